@@ -0,0 +1,40 @@
+#include "allocation_counter.h"
+
+#ifdef TRANSPORT_COUNT_ALLOCATIONS
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace {
+	std::atomic<size_t> allocation_count{ 0 };
+}
+
+// The array and nothrow forms of the standard library go through these two. The std::align_val_t forms
+// allocate on their own and are not counted; nothing in the program uses over-aligned types.
+void* operator new(std::size_t size) {
+	allocation_count.fetch_add(1, std::memory_order_relaxed);
+	if (void* ptr = std::malloc(size != 0 ? size : 1)) {
+		return ptr;
+	}
+	throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept {
+	std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept {
+	std::free(ptr);
+}
+#endif
+
+namespace allocation_counter {
+
+	size_t GetAllocationCount() {
+#ifdef TRANSPORT_COUNT_ALLOCATIONS
+		return allocation_count.load(std::memory_order_relaxed);
+#else
+		return 0;
+#endif
+	}
+}
\ No newline at end of file
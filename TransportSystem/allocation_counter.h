@@ -0,0 +1,9 @@
+#pragma once
+#include <cstddef>
+
+namespace allocation_counter {
+
+	// Number of heap allocations made so far by all threads. It is counted only in builds configured with
+	// TRANSPORT_COUNT_ALLOCATIONS, which replace the global operator new; otherwise it is always 0.
+	size_t GetAllocationCount();
+}
\ No newline at end of file
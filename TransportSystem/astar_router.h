@@ -0,0 +1,105 @@
+#pragma once
+
+#include "graph.h"
+#include "router.h"
+#include "search_buffers.h"
+
+#include <algorithm>
+#include <optional>
+#include <stdexcept>
+#include <vector>
+
+namespace graph {
+
+    // Goal-directed search. The heuristic passed to BuildRoute must never overestimate the remaining
+    // weight to the target; vertices are re-queued whenever a shorter route to them is found, so it does
+    // not have to be consistent.
+    template <typename Weight>
+    class AStarRouter {
+    private:
+        using Graph = DirectedWeightedGraph<Weight>;
+
+    public:
+        using RouteInfo = typename Router<Weight>::RouteInfo;
+
+        explicit AStarRouter(const Graph& graph);
+
+        template <typename Heuristic>
+        std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to, const Heuristic& heuristic, SearchStats* stats = nullptr) const;
+
+    private:
+        // Queue keys are route weight plus heuristic; the heuristic of a vertex is computed once per query.
+        struct AStarBuffers {
+            SearchBuffers<Weight> search;
+            std::vector<Weight> heuristics;
+        };
+
+        static AStarBuffers& GetSearchBuffers() {
+            thread_local AStarBuffers buffers;
+            return buffers;
+        }
+
+        static constexpr Weight ZERO_WEIGHT{};
+
+        const Graph& graph_;
+    };
+
+    template <typename Weight>
+    AStarRouter<Weight>::AStarRouter(const Graph& graph)
+        : graph_(graph) {
+    }
+
+    template <typename Weight>
+    template <typename Heuristic>
+    std::optional<typename AStarRouter<Weight>::RouteInfo> AStarRouter<Weight>::BuildRoute(VertexId from, VertexId to,
+        const Heuristic& heuristic, SearchStats* stats) const {
+        AStarBuffers& buffers = GetSearchBuffers();
+        SearchBuffers<Weight>& search = buffers.search;
+        search.Prepare(graph_.GetVertexCount());
+        if (buffers.heuristics.size() < graph_.GetVertexCount()) {
+            buffers.heuristics.resize(graph_.GetVertexCount());
+        }
+
+        auto reach = [&](VertexId vertex, Weight weight, EdgeId prev_edge) {
+            if (!search.IsReached(vertex)) {
+                buffers.heuristics[vertex] = heuristic(vertex);
+            }
+            search.Reach(vertex, weight, prev_edge, weight + buffers.heuristics[vertex]);
+        };
+
+        size_t settled_vertices = 0;
+        reach(from, ZERO_WEIGHT, 0);
+        while (!search.heap.empty()) {
+            const auto item = search.PopMin();
+            if (search.weights[item.vertex] + buffers.heuristics[item.vertex] < item.weight) {
+                continue;
+            }
+            settled_vertices++;
+            if (item.vertex == to) {
+                break;
+            }
+            for (const EdgeId edge_id : graph_.GetIncidentEdges(item.vertex)) {
+                const auto& edge = graph_.GetEdge(edge_id);
+                const Weight candidate_weight = search.weights[item.vertex] + edge.weight;
+                if (!search.IsReached(edge.to) || candidate_weight < search.weights[edge.to]) {
+                    reach(edge.to, candidate_weight, edge_id);
+                }
+            }
+        }
+        if (stats != nullptr) {
+            stats->settled_vertices = settled_vertices;
+        }
+
+        if (!search.IsReached(to)) {
+            return std::nullopt;
+        }
+        std::vector<EdgeId> edges;
+        for (VertexId vertex = to; vertex != from; vertex = graph_.GetEdge(edges.back()).from) {
+            edges.push_back(search.prev_edges[vertex]);
+        }
+        std::reverse(edges.begin(), edges.end());
+
+        return RouteInfo{ search.weights[to], std::move(edges) };
+    }
+
+}  // namespace graph
@@ -0,0 +1,135 @@
+#pragma once
+
+#include "graph.h"
+#include "router.h"
+#include "search_buffers.h"
+
+#include <algorithm>
+#include <optional>
+#include <stdexcept>
+#include <vector>
+
+namespace graph {
+
+    // Searches forward from the source over the incident edges and backward from the target over the
+    // incoming ones, always advancing the side with the smaller queue minimum. Once the two minimums
+    // together reach the weight of the best route through a vertex reached by both sides, no shorter
+    // route is left, so each side only covers about half of the distance.
+    template <typename Weight>
+    class BidirectionalDijkstraRouter {
+    private:
+        using Graph = DirectedWeightedGraph<Weight>;
+
+    public:
+        using RouteInfo = typename Router<Weight>::RouteInfo;
+
+        explicit BidirectionalDijkstraRouter(const Graph& graph);
+
+        std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to, SearchStats* stats = nullptr) const;
+
+    private:
+        using SearchBuffers = graph::SearchBuffers<Weight>;
+        using QueueItem = typename SearchBuffers::QueueItem;
+
+        struct BidirectionalBuffers {
+            SearchBuffers forward;
+            SearchBuffers backward;
+        };
+
+        static BidirectionalBuffers& GetSearchBuffers() {
+            thread_local BidirectionalBuffers buffers;
+            return buffers;
+        }
+
+        static constexpr Weight ZERO_WEIGHT{};
+
+        const Graph& graph_;
+    };
+
+    template <typename Weight>
+    BidirectionalDijkstraRouter<Weight>::BidirectionalDijkstraRouter(const Graph& graph)
+        : graph_(graph) {
+    }
+
+    template <typename Weight>
+    std::optional<typename BidirectionalDijkstraRouter<Weight>::RouteInfo> BidirectionalDijkstraRouter<Weight>::BuildRoute(VertexId from,
+        VertexId to, SearchStats* stats) const {
+        if (from == to) {
+            if (stats != nullptr) {
+                stats->settled_vertices = 0;
+            }
+            return RouteInfo{ ZERO_WEIGHT, {} };
+        }
+
+        BidirectionalBuffers& buffers = GetSearchBuffers();
+        SearchBuffers& forward = buffers.forward;
+        SearchBuffers& backward = buffers.backward;
+        forward.Prepare(graph_.GetVertexCount());
+        backward.Prepare(graph_.GetVertexCount());
+        forward.Reach(from, ZERO_WEIGHT, 0);
+        backward.Reach(to, ZERO_WEIGHT, 0);
+
+        std::optional<Weight> best_weight;
+        VertexId meeting_vertex = from;
+        auto account_meeting = [&](VertexId vertex, Weight weight) {
+            if (!best_weight || weight < *best_weight) {
+                best_weight = weight;
+                meeting_vertex = vertex;
+            }
+        };
+
+        size_t settled_vertices = 0;
+        while (!forward.heap.empty() && !backward.heap.empty()) {
+            if (best_weight && !(forward.Top().weight + backward.Top().weight < *best_weight)) {
+                break;
+            }
+            const bool is_forward = !(backward.Top().weight < forward.Top().weight);
+            SearchBuffers& search = is_forward ? forward : backward;
+            const SearchBuffers& other = is_forward ? backward : forward;
+
+            const QueueItem item = search.PopMin();
+            if (search.weights[item.vertex] < item.weight) {
+                continue;
+            }
+            settled_vertices++;
+
+            auto relax = [&](EdgeId edge_id, VertexId next_vertex) {
+                const Weight candidate_weight = item.weight + graph_.GetEdge(edge_id).weight;
+                if (!search.IsReached(next_vertex) || candidate_weight < search.weights[next_vertex]) {
+                    search.Reach(next_vertex, candidate_weight, edge_id);
+                }
+                if (other.IsReached(next_vertex)) {
+                    account_meeting(next_vertex, search.weights[next_vertex] + other.weights[next_vertex]);
+                }
+            };
+            if (is_forward) {
+                for (const EdgeId edge_id : graph_.GetIncidentEdges(item.vertex)) {
+                    relax(edge_id, graph_.GetEdge(edge_id).to);
+                }
+            }
+            else {
+                for (const EdgeId edge_id : graph_.GetIncomingEdges(item.vertex)) {
+                    relax(edge_id, graph_.GetEdge(edge_id).from);
+                }
+            }
+        }
+        if (stats != nullptr) {
+            stats->settled_vertices = settled_vertices;
+        }
+
+        if (!best_weight) {
+            return std::nullopt;
+        }
+        std::vector<EdgeId> edges;
+        for (VertexId vertex = meeting_vertex; vertex != from; vertex = graph_.GetEdge(edges.back()).from) {
+            edges.push_back(forward.prev_edges[vertex]);
+        }
+        std::reverse(edges.begin(), edges.end());
+        for (VertexId vertex = meeting_vertex; vertex != to; vertex = graph_.GetEdge(edges.back()).to) {
+            edges.push_back(backward.prev_edges[vertex]);
+        }
+
+        return RouteInfo{ *best_weight, std::move(edges) };
+    }
+
+}  // namespace graph
\ No newline at end of file
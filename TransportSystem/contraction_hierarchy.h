@@ -0,0 +1,407 @@
+#pragma once
+
+#include "graph.h"
+#include "ranges.h"
+#include "router.h"
+#include "search_buffers.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+    // Contraction Hierarchies. Vertices are contracted one by one from the least important, and a shortcut
+    // is added whenever the contracted vertex lies on the only short path between two of its neighbours.
+    // A query is a bidirectional search that only moves towards more important vertices; shortcuts on the
+    // found path are unpacked back into edges of the original graph.
+    template <typename Weight>
+    class ContractionHierarchy {
+    private:
+        using Graph = DirectedWeightedGraph<Weight>;
+
+    public:
+        using RouteInfo = typename Router<Weight>::RouteInfo;
+
+        // Replaces the path first_edge, second_edge. Hierarchy edge ids below the graph's edge count are edges
+        // of the graph itself, the id GetEdgeCount() + i refers to shortcuts_[i].
+        struct Shortcut {
+            VertexId from;
+            VertexId to;
+            Weight weight;
+            EdgeId first_edge;
+            EdgeId second_edge;
+        };
+
+        explicit ContractionHierarchy(const Graph& graph);
+
+        ContractionHierarchy(const Graph& graph, std::vector<uint32_t>&& ranks, std::vector<Shortcut>&& shortcuts);
+
+        const std::vector<uint32_t>& GetRanks() const {
+            return ranks_;
+        }
+
+        const std::vector<Shortcut>& GetShortcuts() const {
+            return shortcuts_;
+        }
+
+        std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const;
+
+        // Hierarchy edges leading from the vertex to more important ones, or if !forward, leading into it
+        // from more important ones.
+        ranges::Range<std::vector<EdgeId>::const_iterator> GetUpwardEdges(VertexId vertex, bool forward) const {
+            const std::vector<size_t>& offsets = forward ? forward_offsets_ : backward_offsets_;
+            const std::vector<EdgeId>& upward_edges = forward ? forward_edges_ : backward_edges_;
+            return { upward_edges.begin() + offsets[vertex], upward_edges.begin() + offsets[vertex + 1] };
+        }
+
+        Edge<Weight> GetHierarchyEdge(EdgeId edge_id) const {
+            if (edge_id < graph_.GetEdgeCount()) {
+                return graph_.GetEdge(edge_id);
+            }
+            const Shortcut& shortcut = shortcuts_[edge_id - graph_.GetEdgeCount()];
+            return { shortcut.from, shortcut.to, shortcut.weight };
+        }
+
+        // Appends the edges of the graph that the hierarchy edge stands for.
+        void UnpackEdge(EdgeId edge_id, std::vector<EdgeId>& edges) const;
+
+    private:
+        using SearchBuffers = graph::SearchBuffers<Weight>;
+
+        struct Arc {
+            VertexId neighbor;
+            Weight weight;
+            EdgeId edge_id;
+        };
+
+        struct ContractionState {
+            std::vector<std::vector<Arc>> out_arcs;
+            std::vector<std::vector<Arc>> in_arcs;
+            std::vector<bool> contracted;
+            SearchBuffers witness_buffers;
+        };
+
+        void Contract();
+
+        void AddArc(ContractionState& state, VertexId from, VertexId to, Weight weight, EdgeId edge_id) const;
+
+        // Counts (and with add_shortcuts == true, creates) the shortcuts needed to contract the vertex.
+        int ContractVertex(ContractionState& state, VertexId vertex, bool add_shortcuts);
+
+        void RunWitnessSearch(ContractionState& state, VertexId source, VertexId excluded, Weight max_weight) const;
+
+        void BuildSearchGraph();
+
+        static std::pair<SearchBuffers, SearchBuffers>& GetSearchBuffers() {
+            thread_local std::pair<SearchBuffers, SearchBuffers> buffers;
+            return buffers;
+        }
+
+        static constexpr Weight ZERO_WEIGHT{};
+        static constexpr size_t WITNESS_SETTLE_LIMIT = 64;
+
+        const Graph& graph_;
+        std::vector<uint32_t> ranks_;
+        std::vector<Shortcut> shortcuts_;
+
+        // Upward search graph: forward edges lead from a vertex to a more important one, backward edges lead
+        // into a vertex from a more important one. Both are kept as offsets into flat arrays of hierarchy edge ids.
+        std::vector<size_t> forward_offsets_;
+        std::vector<EdgeId> forward_edges_;
+        std::vector<size_t> backward_offsets_;
+        std::vector<EdgeId> backward_edges_;
+    };
+
+    template <typename Weight>
+    ContractionHierarchy<Weight>::ContractionHierarchy(const Graph& graph)
+        : graph_(graph)
+    {
+        Contract();
+        BuildSearchGraph();
+    }
+
+    template <typename Weight>
+    ContractionHierarchy<Weight>::ContractionHierarchy(const Graph& graph, std::vector<uint32_t>&& ranks, std::vector<Shortcut>&& shortcuts)
+        : graph_(graph)
+        , ranks_(std::move(ranks))
+        , shortcuts_(std::move(shortcuts))
+    {
+        if (ranks_.size() != graph.GetVertexCount()) {
+            throw std::invalid_argument("Contraction hierarchy does not match the graph");
+        }
+        BuildSearchGraph();
+    }
+
+    template <typename Weight>
+    void ContractionHierarchy<Weight>::Contract() {
+        const size_t vertex_count = graph_.GetVertexCount();
+        ContractionState state;
+        state.out_arcs.resize(vertex_count);
+        state.in_arcs.resize(vertex_count);
+        state.contracted.assign(vertex_count, false);
+        for (EdgeId edge_id = 0; edge_id < graph_.GetEdgeCount(); ++edge_id) {
+            const auto& edge = graph_.GetEdge(edge_id);
+            if (edge.from != edge.to) {
+                AddArc(state, edge.from, edge.to, edge.weight, edge_id);
+            }
+        }
+
+        // Importance of a vertex: how many edges its contraction adds minus how many it removes,
+        // plus the number of already contracted neighbours to keep the contraction spread out.
+        std::vector<int> contracted_neighbors(vertex_count, 0);
+        auto compute_priority = [&](VertexId vertex) {
+            int removed_arcs = 0;
+            for (const Arc& arc : state.in_arcs[vertex]) {
+                removed_arcs += state.contracted[arc.neighbor] ? 0 : 1;
+            }
+            for (const Arc& arc : state.out_arcs[vertex]) {
+                removed_arcs += state.contracted[arc.neighbor] ? 0 : 1;
+            }
+            return ContractVertex(state, vertex, false) - removed_arcs + contracted_neighbors[vertex];
+        };
+
+        using QueueItem = std::pair<int, VertexId>;
+        std::vector<QueueItem> queue;
+        for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+            queue.push_back({ compute_priority(vertex), vertex });
+        }
+        std::make_heap(queue.begin(), queue.end(), std::greater<QueueItem>{});
+
+        ranks_.assign(vertex_count, 0);
+        uint32_t next_rank = 0;
+        while (!queue.empty()) {
+            std::pop_heap(queue.begin(), queue.end(), std::greater<QueueItem>{});
+            const VertexId vertex = queue.back().second;
+            queue.pop_back();
+            if (state.contracted[vertex]) {
+                continue;
+            }
+            const int priority = compute_priority(vertex);
+            if (!queue.empty() && priority > queue.front().first) {
+                queue.push_back({ priority, vertex });
+                std::push_heap(queue.begin(), queue.end(), std::greater<QueueItem>{});
+                continue;
+            }
+
+            ContractVertex(state, vertex, true);
+            state.contracted[vertex] = true;
+            ranks_[vertex] = next_rank++;
+            for (const Arc& arc : state.in_arcs[vertex]) {
+                contracted_neighbors[arc.neighbor]++;
+            }
+            for (const Arc& arc : state.out_arcs[vertex]) {
+                contracted_neighbors[arc.neighbor]++;
+            }
+        }
+    }
+
+    template <typename Weight>
+    void ContractionHierarchy<Weight>::AddArc(ContractionState& state, VertexId from, VertexId to, Weight weight, EdgeId edge_id) const {
+        for (Arc& arc : state.out_arcs[from]) {
+            if (arc.neighbor != to) {
+                continue;
+            }
+            if (weight < arc.weight) {
+                arc.weight = weight;
+                arc.edge_id = edge_id;
+                for (Arc& reverse_arc : state.in_arcs[to]) {
+                    if (reverse_arc.neighbor == from) {
+                        reverse_arc.weight = weight;
+                        reverse_arc.edge_id = edge_id;
+                    }
+                }
+            }
+            return;
+        }
+        state.out_arcs[from].push_back({ to, weight, edge_id });
+        state.in_arcs[to].push_back({ from, weight, edge_id });
+    }
+
+    template <typename Weight>
+    int ContractionHierarchy<Weight>::ContractVertex(ContractionState& state, VertexId vertex, bool add_shortcuts) {
+        int shortcut_count = 0;
+        // Shortcuts only touch the arc lists of the neighbours, so the lists of the vertex itself stay valid.
+        const std::vector<Arc>& in_arcs = state.in_arcs[vertex];
+        const std::vector<Arc>& out_arcs = state.out_arcs[vertex];
+        for (const Arc& in_arc : in_arcs) {
+            if (state.contracted[in_arc.neighbor]) {
+                continue;
+            }
+            std::optional<Weight> max_weight;
+            for (const Arc& out_arc : out_arcs) {
+                if (!state.contracted[out_arc.neighbor] && out_arc.neighbor != in_arc.neighbor) {
+                    max_weight = std::max(max_weight.value_or(ZERO_WEIGHT), in_arc.weight + out_arc.weight);
+                }
+            }
+            if (!max_weight) {
+                continue;
+            }
+
+            RunWitnessSearch(state, in_arc.neighbor, vertex, *max_weight);
+            const SearchBuffers& witness = state.witness_buffers;
+            for (const Arc& out_arc : out_arcs) {
+                if (state.contracted[out_arc.neighbor] || out_arc.neighbor == in_arc.neighbor) {
+                    continue;
+                }
+                const Weight shortcut_weight = in_arc.weight + out_arc.weight;
+                if (witness.IsReached(out_arc.neighbor) && !(shortcut_weight < witness.weights[out_arc.neighbor])) {
+                    continue;
+                }
+                shortcut_count++;
+                if (add_shortcuts) {
+                    shortcuts_.push_back({ in_arc.neighbor, out_arc.neighbor, shortcut_weight, in_arc.edge_id, out_arc.edge_id });
+                    AddArc(state, in_arc.neighbor, out_arc.neighbor, shortcut_weight, graph_.GetEdgeCount() + shortcuts_.size() - 1);
+                }
+            }
+        }
+        return shortcut_count;
+    }
+
+    template <typename Weight>
+    void ContractionHierarchy<Weight>::RunWitnessSearch(ContractionState& state, VertexId source, VertexId excluded, Weight max_weight) const {
+        SearchBuffers& buffers = state.witness_buffers;
+        buffers.Prepare(graph_.GetVertexCount());
+        buffers.Reach(source, ZERO_WEIGHT, 0);
+        size_t settled_count = 0;
+        while (!buffers.heap.empty() && settled_count < WITNESS_SETTLE_LIMIT) {
+            const auto item = buffers.PopMin();
+            if (buffers.weights[item.vertex] < item.weight) {
+                continue;
+            }
+            if (max_weight < item.weight) {
+                break;
+            }
+            settled_count++;
+            for (const Arc& arc : state.out_arcs[item.vertex]) {
+                if (arc.neighbor == excluded || state.contracted[arc.neighbor]) {
+                    continue;
+                }
+                const Weight candidate_weight = item.weight + arc.weight;
+                if (!buffers.IsReached(arc.neighbor) || candidate_weight < buffers.weights[arc.neighbor]) {
+                    buffers.Reach(arc.neighbor, candidate_weight, arc.edge_id);
+                }
+            }
+        }
+    }
+
+    template <typename Weight>
+    void ContractionHierarchy<Weight>::BuildSearchGraph() {
+        const size_t vertex_count = graph_.GetVertexCount();
+        const size_t edge_count = graph_.GetEdgeCount() + shortcuts_.size();
+        forward_offsets_.assign(vertex_count + 1, 0);
+        backward_offsets_.assign(vertex_count + 1, 0);
+        for (EdgeId edge_id = 0; edge_id < edge_count; ++edge_id) {
+            const Edge<Weight> edge = GetHierarchyEdge(edge_id);
+            if (ranks_[edge.from] < ranks_[edge.to]) {
+                forward_offsets_[edge.from + 1]++;
+            }
+            else if (ranks_[edge.to] < ranks_[edge.from]) {
+                backward_offsets_[edge.to + 1]++;
+            }
+        }
+        for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+            forward_offsets_[vertex + 1] += forward_offsets_[vertex];
+            backward_offsets_[vertex + 1] += backward_offsets_[vertex];
+        }
+        forward_edges_.resize(forward_offsets_[vertex_count]);
+        backward_edges_.resize(backward_offsets_[vertex_count]);
+        std::vector<size_t> forward_positions(forward_offsets_.begin(), forward_offsets_.end() - 1);
+        std::vector<size_t> backward_positions(backward_offsets_.begin(), backward_offsets_.end() - 1);
+        for (EdgeId edge_id = 0; edge_id < edge_count; ++edge_id) {
+            const Edge<Weight> edge = GetHierarchyEdge(edge_id);
+            if (ranks_[edge.from] < ranks_[edge.to]) {
+                forward_edges_[forward_positions[edge.from]++] = edge_id;
+            }
+            else if (ranks_[edge.to] < ranks_[edge.from]) {
+                backward_edges_[backward_positions[edge.to]++] = edge_id;
+            }
+        }
+    }
+
+    template <typename Weight>
+    void ContractionHierarchy<Weight>::UnpackEdge(EdgeId edge_id, std::vector<EdgeId>& edges) const {
+        std::vector<EdgeId> stack = { edge_id };
+        while (!stack.empty()) {
+            const EdgeId current = stack.back();
+            stack.pop_back();
+            if (current < graph_.GetEdgeCount()) {
+                edges.push_back(current);
+                continue;
+            }
+            const Shortcut& shortcut = shortcuts_[current - graph_.GetEdgeCount()];
+            stack.push_back(shortcut.second_edge);
+            stack.push_back(shortcut.first_edge);
+        }
+    }
+
+    template <typename Weight>
+    std::optional<typename ContractionHierarchy<Weight>::RouteInfo> ContractionHierarchy<Weight>::BuildRoute(VertexId from,
+        VertexId to) const {
+        auto& [forward, backward] = GetSearchBuffers();
+        forward.Prepare(graph_.GetVertexCount());
+        backward.Prepare(graph_.GetVertexCount());
+        forward.Reach(from, ZERO_WEIGHT, 0);
+        backward.Reach(to, ZERO_WEIGHT, 0);
+
+        std::optional<VertexId> meeting_vertex;
+        Weight best_weight = ZERO_WEIGHT;
+        auto is_active = [&](const SearchBuffers& buffers) {
+            return !buffers.heap.empty() && (!meeting_vertex || buffers.Top().weight < best_weight);
+        };
+
+        bool forward_turn = true;
+        while (is_active(forward) || is_active(backward)) {
+            const bool is_forward = is_active(forward) && (forward_turn || !is_active(backward));
+            forward_turn = !forward_turn;
+            SearchBuffers& current = is_forward ? forward : backward;
+            const SearchBuffers& opposite = is_forward ? backward : forward;
+
+            const auto item = current.PopMin();
+            if (current.weights[item.vertex] < item.weight) {
+                continue;
+            }
+            if (opposite.IsReached(item.vertex)) {
+                const Weight candidate_weight = item.weight + opposite.weights[item.vertex];
+                if (!meeting_vertex || candidate_weight < best_weight) {
+                    meeting_vertex = item.vertex;
+                    best_weight = candidate_weight;
+                }
+            }
+
+            for (const EdgeId edge_id : GetUpwardEdges(item.vertex, is_forward)) {
+                const Edge<Weight> edge = GetHierarchyEdge(edge_id);
+                const VertexId next = is_forward ? edge.to : edge.from;
+                const Weight candidate_weight = item.weight + edge.weight;
+                if (!current.IsReached(next) || candidate_weight < current.weights[next]) {
+                    current.Reach(next, candidate_weight, edge_id);
+                }
+            }
+        }
+
+        if (!meeting_vertex) {
+            return std::nullopt;
+        }
+
+        std::vector<EdgeId> forward_path;
+        for (VertexId vertex = *meeting_vertex; vertex != from; vertex = GetHierarchyEdge(forward_path.back()).from) {
+            forward_path.push_back(forward.prev_edges[vertex]);
+        }
+        std::vector<EdgeId> edges;
+        for (auto it = forward_path.rbegin(); it != forward_path.rend(); ++it) {
+            UnpackEdge(*it, edges);
+        }
+        for (VertexId vertex = *meeting_vertex; vertex != to;) {
+            const EdgeId edge_id = backward.prev_edges[vertex];
+            UnpackEdge(edge_id, edges);
+            vertex = GetHierarchyEdge(edge_id).to;
+        }
+
+        return RouteInfo{ best_weight, std::move(edges) };
+    }
+
+}  // namespace graph
@@ -0,0 +1,165 @@
+#pragma once
+
+#include "graph.h"
+#include "router.h"
+#include "search_buffers.h"
+
+#include <algorithm>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+    // Answers route queries with a single-source search instead of the all-pairs table of Router,
+    // so nothing but the graph itself has to be precomputed.
+    template <typename Weight>
+    class DijkstraRouter {
+    private:
+        using Graph = DirectedWeightedGraph<Weight>;
+
+    public:
+        using RouteInfo = typename Router<Weight>::RouteInfo;
+
+        explicit DijkstraRouter(const Graph& graph);
+
+        std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to, SearchStats* stats = nullptr) const;
+
+        // Weights of the shortest routes from one vertex to each of targets, found by a single search
+        // that stops as soon as every target is settled.
+        std::vector<std::optional<Weight>> BuildWeights(VertexId from, const std::vector<VertexId>& targets) const;
+
+        // Every vertex whose shortest route from one vertex weighs at most max_weight, in the order of
+        // increasing weight. The search never settles anything beyond the bound.
+        std::vector<std::pair<VertexId, Weight>> BuildWeightsWithin(VertexId from, Weight max_weight) const;
+
+    private:
+        using SearchBuffers = graph::SearchBuffers<Weight>;
+        using QueueItem = typename SearchBuffers::QueueItem;
+
+        static SearchBuffers& GetSearchBuffers() {
+            thread_local SearchBuffers buffers;
+            return buffers;
+        }
+
+        static constexpr Weight ZERO_WEIGHT{};
+
+        const Graph& graph_;
+    };
+
+    template <typename Weight>
+    DijkstraRouter<Weight>::DijkstraRouter(const Graph& graph)
+        : graph_(graph) {
+    }
+
+    template <typename Weight>
+    std::optional<typename DijkstraRouter<Weight>::RouteInfo> DijkstraRouter<Weight>::BuildRoute(VertexId from,
+        VertexId to, SearchStats* stats) const {
+        SearchBuffers& buffers = GetSearchBuffers();
+        buffers.Prepare(graph_.GetVertexCount());
+        buffers.Reach(from, ZERO_WEIGHT, 0);
+
+        size_t settled_vertices = 0;
+        while (!buffers.heap.empty()) {
+            const QueueItem item = buffers.PopMin();
+            if (buffers.weights[item.vertex] < item.weight) {
+                continue;
+            }
+            settled_vertices++;
+            if (item.vertex == to) {
+                break;
+            }
+            for (const EdgeId edge_id : graph_.GetIncidentEdges(item.vertex)) {
+                const auto& edge = graph_.GetEdge(edge_id);
+                const Weight candidate_weight = item.weight + edge.weight;
+                if (!buffers.IsReached(edge.to) || candidate_weight < buffers.weights[edge.to]) {
+                    buffers.Reach(edge.to, candidate_weight, edge_id);
+                }
+            }
+        }
+        if (stats != nullptr) {
+            stats->settled_vertices = settled_vertices;
+        }
+
+        if (!buffers.IsReached(to)) {
+            return std::nullopt;
+        }
+        std::vector<EdgeId> edges;
+        for (VertexId vertex = to; vertex != from; vertex = graph_.GetEdge(edges.back()).from) {
+            edges.push_back(buffers.prev_edges[vertex]);
+        }
+        std::reverse(edges.begin(), edges.end());
+
+        return RouteInfo{ buffers.weights[to], std::move(edges) };
+    }
+
+    template <typename Weight>
+    std::vector<std::optional<Weight>> DijkstraRouter<Weight>::BuildWeights(VertexId from,
+        const std::vector<VertexId>& targets) const {
+        std::vector<bool> is_target(graph_.GetVertexCount(), false);
+        size_t remaining_targets = 0;
+        for (const VertexId target : targets) {
+            if (!is_target[target]) {
+                is_target[target] = true;
+                remaining_targets++;
+            }
+        }
+
+        SearchBuffers& buffers = GetSearchBuffers();
+        buffers.Prepare(graph_.GetVertexCount());
+        buffers.Reach(from, ZERO_WEIGHT, 0);
+        while (!buffers.heap.empty() && remaining_targets != 0) {
+            const QueueItem item = buffers.PopMin();
+            if (buffers.weights[item.vertex] < item.weight) {
+                continue;
+            }
+            if (is_target[item.vertex]) {
+                is_target[item.vertex] = false;
+                remaining_targets--;
+            }
+            for (const EdgeId edge_id : graph_.GetIncidentEdges(item.vertex)) {
+                const auto& edge = graph_.GetEdge(edge_id);
+                const Weight candidate_weight = item.weight + edge.weight;
+                if (!buffers.IsReached(edge.to) || candidate_weight < buffers.weights[edge.to]) {
+                    buffers.Reach(edge.to, candidate_weight, edge_id);
+                }
+            }
+        }
+
+        std::vector<std::optional<Weight>> result;
+        result.reserve(targets.size());
+        for (const VertexId target : targets) {
+            result.push_back(buffers.IsReached(target) ? std::optional<Weight>(buffers.weights[target]) : std::nullopt);
+        }
+        return result;
+    }
+
+    template <typename Weight>
+    std::vector<std::pair<VertexId, Weight>> DijkstraRouter<Weight>::BuildWeightsWithin(VertexId from,
+        Weight max_weight) const {
+        std::vector<std::pair<VertexId, Weight>> result;
+        SearchBuffers& buffers = GetSearchBuffers();
+        buffers.Prepare(graph_.GetVertexCount());
+        buffers.Reach(from, ZERO_WEIGHT, 0);
+        while (!buffers.heap.empty()) {
+            const QueueItem item = buffers.PopMin();
+            if (max_weight < item.weight) {
+                break;
+            }
+            if (buffers.weights[item.vertex] < item.weight) {
+                continue;
+            }
+            result.emplace_back(item.vertex, item.weight);
+            for (const EdgeId edge_id : graph_.GetIncidentEdges(item.vertex)) {
+                const auto& edge = graph_.GetEdge(edge_id);
+                const Weight candidate_weight = item.weight + edge.weight;
+                if (!buffers.IsReached(edge.to) || candidate_weight < buffers.weights[edge.to]) {
+                    buffers.Reach(edge.to, candidate_weight, edge_id);
+                }
+            }
+        }
+        return result;
+    }
+
+}  // namespace graph
@@ -0,0 +1,127 @@
+#pragma once
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace transportcatalogue {
+
+	// Road lengths between stops in a flat hash table with linear probing. The key is the pair of stop ids
+	// packed into 64 bits, keys and lengths are kept in two parallel arrays at most three quarters full.
+	class StopDistanceTable {
+	public:
+		// Keeps an already known length, as the first length given for a pair of stops wins.
+		void Insert(uint32_t from_id, uint32_t to_id, uint32_t lenght) {
+			const size_t slot = FindSlotForInsert(GetKey(from_id, to_id));
+			if (keys_[slot] == EMPTY_KEY) {
+				keys_[slot] = GetKey(from_id, to_id);
+				lenghts_[slot] = lenght;
+				++size_;
+			}
+		}
+
+		void Set(uint32_t from_id, uint32_t to_id, uint32_t lenght) {
+			const size_t slot = FindSlotForInsert(GetKey(from_id, to_id));
+			if (keys_[slot] == EMPTY_KEY) {
+				keys_[slot] = GetKey(from_id, to_id);
+				++size_;
+			}
+			lenghts_[slot] = lenght;
+		}
+
+		// The length from from_id to to_id or, when only that one is known, in the opposite direction.
+		std::optional<uint32_t> Find(uint32_t from_id, uint32_t to_id) const {
+			if (keys_.empty()) {
+				return std::nullopt;
+			}
+			if (const uint32_t* lenght = FindExact(GetKey(from_id, to_id))) {
+				return *lenght;
+			}
+			if (const uint32_t* lenght = FindExact(GetKey(to_id, from_id))) {
+				return *lenght;
+			}
+			return std::nullopt;
+		}
+
+		size_t GetSize() const {
+			return size_;
+		}
+
+		// Calls action(from_id, to_id, lenght) for every stored length in no particular order.
+		template <typename Action>
+		void ForEach(const Action& action) const {
+			for (size_t slot = 0; slot < keys_.size(); ++slot) {
+				if (keys_[slot] != EMPTY_KEY) {
+					action(static_cast<uint32_t>(keys_[slot] >> 32), static_cast<uint32_t>(keys_[slot]), lenghts_[slot]);
+				}
+			}
+		}
+
+	private:
+		static constexpr uint64_t EMPTY_KEY = std::numeric_limits<uint64_t>::max();
+		static constexpr size_t MIN_CAPACITY = 16;
+
+		static uint64_t GetKey(uint32_t from_id, uint32_t to_id) {
+			return (static_cast<uint64_t>(from_id) << 32) | to_id;
+		}
+
+		// Fibonacci hashing: the high bits of the product depend on all bits of the key.
+		size_t GetHomeSlot(uint64_t key) const {
+			return static_cast<size_t>((key * 0x9E3779B97F4A7C15ull) >> (64 - capacity_bits_));
+		}
+
+		const uint32_t* FindExact(uint64_t key) const {
+			const size_t mask = keys_.size() - 1;
+			for (size_t slot = GetHomeSlot(key);; slot = (slot + 1) & mask) {
+				if (keys_[slot] == key) {
+					return &lenghts_[slot];
+				}
+				if (keys_[slot] == EMPTY_KEY) {
+					return nullptr;
+				}
+			}
+		}
+
+		// The slot holding the key or the empty slot where it belongs, after growing if needed.
+		size_t FindSlotForInsert(uint64_t key) {
+			if (4 * (size_ + 1) > 3 * keys_.size()) {
+				Rehash(keys_.empty() ? MIN_CAPACITY : 2 * keys_.size());
+			}
+			const size_t mask = keys_.size() - 1;
+			size_t slot = GetHomeSlot(key);
+			while (keys_[slot] != key && keys_[slot] != EMPTY_KEY) {
+				slot = (slot + 1) & mask;
+			}
+			return slot;
+		}
+
+		void Rehash(size_t capacity) {
+			std::vector<uint64_t> keys(capacity, EMPTY_KEY);
+			std::vector<uint32_t> lenghts(capacity, 0);
+			std::swap(keys, keys_);
+			std::swap(lenghts, lenghts_);
+			capacity_bits_ = 0;
+			while ((size_t{ 1 } << capacity_bits_) < capacity) {
+				++capacity_bits_;
+			}
+			const size_t mask = capacity - 1;
+			for (size_t old_slot = 0; old_slot < keys.size(); ++old_slot) {
+				if (keys[old_slot] == EMPTY_KEY) {
+					continue;
+				}
+				size_t slot = GetHomeSlot(keys[old_slot]);
+				while (keys_[slot] != EMPTY_KEY) {
+					slot = (slot + 1) & mask;
+				}
+				keys_[slot] = keys[old_slot];
+				lenghts_[slot] = lenghts[old_slot];
+			}
+		}
+
+		std::vector<uint64_t> keys_;
+		std::vector<uint32_t> lenghts_;
+		size_t size_ = 0;
+		int capacity_bits_ = 0;
+	};
+}
\ No newline at end of file
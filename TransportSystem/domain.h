@@ -1,15 +1,20 @@
 #pragma once
 
+#include <cstdint>
 #include <deque>
 #include <string>
+#include <vector>
 
 #include "geo.h"
+#include "ranges.h"
 
 namespace transportcatalogue {
 
+	// Stops and buses are numbered densely in the order they enter the catalogue.
 	struct Stop {
 		std::string name;
 		geo::Coordinates coordinates;
+		uint32_t id = 0;
 
 		geo::Coordinates GetCoord() const;
 	};
@@ -18,11 +23,13 @@ namespace transportcatalogue {
 		std::string name;
 		std::deque<Stop*> stops;
 		bool is_loop_trip;
+		uint32_t id = 0;
 	};
 
 	struct StopInfo {
 		bool exists;
-		std::deque<std::string_view> buses;
+		// Ids of the buses through the stop sorted by name, a view into the index of the catalogue.
+		ranges::Range<std::vector<uint32_t>::const_iterator> buses;
 	};
 
 	struct BusInfo {
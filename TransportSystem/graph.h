@@ -2,7 +2,9 @@
 
 #include "ranges.h"
 
+#include <cassert>
 #include <cstdlib>
+#include <stdexcept>
 #include <vector>
 
 namespace graph {
@@ -17,48 +19,132 @@ namespace graph {
         Weight weight;
     };
 
+    // Edges are added one by one and then frozen into compressed sparse rows: edges sorted by source
+    // vertex, so the incident edges of a vertex are the ids offsets_[vertex] .. offsets_[vertex + 1].
+    // Freezing also builds the reverse adjacency, the ids of the edges entering every vertex.
+    // Traversal is only possible on a frozen graph and does no bounds checks.
+    // Weights are checked to be non-negative on the way in, which every router relies on.
     template <typename Weight>
     class DirectedWeightedGraph {
     private:
-        using IncidenceList = std::vector<EdgeId>;
-        using IncidentEdgesRange = ranges::Range<typename IncidenceList::const_iterator>;
+        using IncidentEdgesRange = ranges::Range<ranges::IdIterator<EdgeId>>;
+        using IncomingEdgesRange = ranges::Range<std::vector<EdgeId>::const_iterator>;
 
     public:
         DirectedWeightedGraph() = default;
-        DirectedWeightedGraph(std::vector<Edge<Weight>>&& edges, std::vector<IncidenceList>&& incidence_lists) : edges_(std::move(edges)), incidence_lists_(std::move(incidence_lists)) {}
+        // Loads an already frozen graph; edges must be sorted by source vertex.
+        DirectedWeightedGraph(std::vector<EdgeId>&& offsets, std::vector<Edge<Weight>>&& edges)
+            : vertex_count_(offsets.empty() ? 0 : offsets.size() - 1)
+            , edges_(std::move(edges))
+            , offsets_(std::move(offsets)) {
+            for (const Edge<Weight>& edge : edges_) {
+                CheckWeight(edge.weight);
+            }
+            BuildReverseAdjacency();
+        }
         explicit DirectedWeightedGraph(size_t vertex_count);
         EdgeId AddEdge(const Edge<Weight>& edge);
 
+        // Sorts the edges by source vertex, keeping the order of addition among edges of one vertex.
+        // Returns the new id of every edge indexed by the id AddEdge gave it.
+        std::vector<EdgeId> Freeze();
+
+        bool IsFrozen() const {
+            return offsets_.size() == vertex_count_ + 1;
+        }
+
         size_t GetVertexCount() const;
         size_t GetEdgeCount() const;
         const Edge<Weight>& GetEdge(EdgeId edge_id) const;
         IncidentEdgesRange GetIncidentEdges(VertexId vertex) const;
+        IncomingEdgesRange GetIncomingEdges(VertexId vertex) const;
 
-        const std::vector<IncidenceList>& GetIncidenceLists() const {
-            return incidence_lists_;
+        const std::vector<EdgeId>& GetOffsets() const {
+            return offsets_;
+        }
+
+        // Keeps the id and the place of the edge, so a frozen graph stays frozen.
+        void SetEdgeWeight(EdgeId edge_id, Weight weight) {
+            CheckWeight(weight);
+            edges_[edge_id].weight = weight;
         }
 
     private:
+        static void CheckWeight(const Weight& weight) {
+            if (weight < Weight{}) {
+                throw std::domain_error("Edges' weights should be non-negative");
+            }
+        }
+
+        void BuildReverseAdjacency();
+
+        size_t vertex_count_ = 0;
         std::vector<Edge<Weight>> edges_;
-        std::vector<IncidenceList> incidence_lists_;
+        std::vector<EdgeId> offsets_;
+        // Edges entering a vertex: reverse_edges_[reverse_offsets_[vertex] .. reverse_offsets_[vertex + 1]).
+        std::vector<EdgeId> reverse_offsets_;
+        std::vector<EdgeId> reverse_edges_;
     };
 
     template <typename Weight>
     DirectedWeightedGraph<Weight>::DirectedWeightedGraph(size_t vertex_count)
-        : incidence_lists_(vertex_count) {
+        : vertex_count_(vertex_count) {
     }
 
     template <typename Weight>
     EdgeId DirectedWeightedGraph<Weight>::AddEdge(const Edge<Weight>& edge) {
+        if (edge.from >= vertex_count_) {
+            throw std::out_of_range("Vertex id is out of range");
+        }
+        CheckWeight(edge.weight);
+        offsets_.clear();
+        reverse_offsets_.clear();
+        reverse_edges_.clear();
         edges_.push_back(edge);
-        const EdgeId id = edges_.size() - 1;
-        incidence_lists_.at(edge.from).push_back(id);
-        return id;
+        return edges_.size() - 1;
+    }
+
+    template <typename Weight>
+    std::vector<EdgeId> DirectedWeightedGraph<Weight>::Freeze() {
+        offsets_.assign(vertex_count_ + 1, 0);
+        for (const Edge<Weight>& edge : edges_) {
+            ++offsets_[edge.from + 1];
+        }
+        for (VertexId vertex = 0; vertex < vertex_count_; ++vertex) {
+            offsets_[vertex + 1] += offsets_[vertex];
+        }
+
+        std::vector<EdgeId> next_ids(offsets_.begin(), offsets_.end() - 1);
+        std::vector<EdgeId> new_ids(edges_.size());
+        std::vector<Edge<Weight>> sorted_edges(edges_.size());
+        for (EdgeId edge_id = 0; edge_id < edges_.size(); ++edge_id) {
+            new_ids[edge_id] = next_ids[edges_[edge_id].from]++;
+            sorted_edges[new_ids[edge_id]] = edges_[edge_id];
+        }
+        edges_ = std::move(sorted_edges);
+        BuildReverseAdjacency();
+        return new_ids;
+    }
+
+    template <typename Weight>
+    void DirectedWeightedGraph<Weight>::BuildReverseAdjacency() {
+        reverse_offsets_.assign(vertex_count_ + 1, 0);
+        for (const Edge<Weight>& edge : edges_) {
+            ++reverse_offsets_[edge.to + 1];
+        }
+        for (VertexId vertex = 0; vertex < vertex_count_; ++vertex) {
+            reverse_offsets_[vertex + 1] += reverse_offsets_[vertex];
+        }
+        std::vector<EdgeId> next_positions(reverse_offsets_.begin(), reverse_offsets_.end() - 1);
+        reverse_edges_.resize(edges_.size());
+        for (EdgeId edge_id = 0; edge_id < edges_.size(); ++edge_id) {
+            reverse_edges_[next_positions[edges_[edge_id].to]++] = edge_id;
+        }
     }
 
     template <typename Weight>
     size_t DirectedWeightedGraph<Weight>::GetVertexCount() const {
-        return incidence_lists_.size();
+        return vertex_count_;
     }
 
     template <typename Weight>
@@ -68,12 +154,20 @@ namespace graph {
 
     template <typename Weight>
     const Edge<Weight>& DirectedWeightedGraph<Weight>::GetEdge(EdgeId edge_id) const {
-        return edges_.at(edge_id);
+        return edges_[edge_id];
     }
 
     template <typename Weight>
     typename DirectedWeightedGraph<Weight>::IncidentEdgesRange
         DirectedWeightedGraph<Weight>::GetIncidentEdges(VertexId vertex) const {
-        return ranges::AsRange(incidence_lists_.at(vertex));
+        assert(IsFrozen());
+        return ranges::IdRange(offsets_[vertex], offsets_[vertex + 1]);
+    }
+
+    template <typename Weight>
+    typename DirectedWeightedGraph<Weight>::IncomingEdgesRange
+        DirectedWeightedGraph<Weight>::GetIncomingEdges(VertexId vertex) const {
+        assert(IsFrozen());
+        return ranges::Range{ reverse_edges_.begin() + reverse_offsets_[vertex], reverse_edges_.begin() + reverse_offsets_[vertex + 1] };
     }
 }  // namespace graph
\ No newline at end of file
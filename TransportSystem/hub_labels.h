@@ -0,0 +1,226 @@
+#pragma once
+
+#include "contraction_hierarchy.h"
+#include "graph.h"
+#include "router.h"
+#include "search_buffers.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+    // Hub labeling derived from a contraction hierarchy. The forward label of a vertex is the search space
+    // of its upward search in the hierarchy, the backward label that of the upward search over incoming
+    // edges. The most important vertex of a shortest route is in both labels with exact weights, so a
+    // query is a merge of two labels sorted by hub. Every label entry keeps the hierarchy edge it was
+    // reached by, whose other end is an earlier hub of the same label, so the route unpacks without a search.
+    template <typename Weight>
+    class HubLabels {
+    private:
+        using Hierarchy = ContractionHierarchy<Weight>;
+
+    public:
+        using RouteInfo = typename Router<Weight>::RouteInfo;
+
+        static constexpr uint32_t NO_EDGE = std::numeric_limits<uint32_t>::max();
+
+        // Labels of all vertices in flat arrays: the entries of vertex v occupy [offsets[v], offsets[v + 1]),
+        // sorted by hub. A vertex is the hub of its own first entry, which has no parent edge.
+        struct Labels {
+            std::vector<uint32_t> offsets;
+            std::vector<uint32_t> hubs;
+            std::vector<Weight> weights;
+            std::vector<uint32_t> parent_edges;
+        };
+
+        // Labels only the given vertices; routes are only built between them.
+        HubLabels(const Hierarchy& hierarchy, const std::vector<VertexId>& vertices);
+
+        HubLabels(const Hierarchy& hierarchy, Labels&& forward_labels, Labels&& backward_labels);
+
+        const Labels& GetForwardLabels() const {
+            return forward_labels_;
+        }
+
+        const Labels& GetBackwardLabels() const {
+            return backward_labels_;
+        }
+
+        std::optional<Weight> GetWeight(VertexId from, VertexId to) const;
+
+        std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const;
+
+    private:
+        struct Meeting {
+            Weight weight;
+            size_t forward_entry;
+            size_t backward_entry;
+        };
+
+        void BuildLabels(const std::vector<VertexId>& vertices, bool forward, Labels& labels) const;
+
+        std::optional<Meeting> FindMeeting(VertexId from, VertexId to) const;
+
+        // Hierarchy edges from the labeled vertex to the hub of the entry, or from the hub to the vertex.
+        std::vector<EdgeId> GetLabelPath(const Labels& labels, VertexId vertex, size_t entry, bool forward) const;
+
+        static constexpr Weight ZERO_WEIGHT{};
+
+        const Hierarchy& hierarchy_;
+        Labels forward_labels_;
+        Labels backward_labels_;
+    };
+
+    template <typename Weight>
+    HubLabels<Weight>::HubLabels(const Hierarchy& hierarchy, const std::vector<VertexId>& vertices)
+        : hierarchy_(hierarchy)
+    {
+        BuildLabels(vertices, true, forward_labels_);
+        BuildLabels(vertices, false, backward_labels_);
+    }
+
+    template <typename Weight>
+    HubLabels<Weight>::HubLabels(const Hierarchy& hierarchy, Labels&& forward_labels, Labels&& backward_labels)
+        : hierarchy_(hierarchy)
+        , forward_labels_(std::move(forward_labels))
+        , backward_labels_(std::move(backward_labels))
+    {
+        const size_t offset_count = hierarchy.GetRanks().size() + 1;
+        if (forward_labels_.offsets.size() != offset_count || backward_labels_.offsets.size() != offset_count) {
+            throw std::invalid_argument("Hub labels do not match the contraction hierarchy");
+        }
+    }
+
+    template <typename Weight>
+    void HubLabels<Weight>::BuildLabels(const std::vector<VertexId>& vertices, bool forward, Labels& labels) const {
+        const size_t vertex_count = hierarchy_.GetRanks().size();
+        std::vector<std::vector<std::pair<VertexId, Weight>>> vertex_labels(vertex_count);
+        std::vector<std::vector<uint32_t>> vertex_parent_edges(vertex_count);
+
+        SearchBuffers<Weight> search;
+        std::vector<VertexId> settled;
+        for (const VertexId vertex : vertices) {
+            search.Prepare(vertex_count);
+            search.Reach(vertex, ZERO_WEIGHT, NO_EDGE);
+            settled.clear();
+            while (!search.heap.empty()) {
+                const auto item = search.PopMin();
+                if (search.weights[item.vertex] < item.weight) {
+                    continue;
+                }
+                settled.push_back(item.vertex);
+                for (const EdgeId edge_id : hierarchy_.GetUpwardEdges(item.vertex, forward)) {
+                    const Edge<Weight> edge = hierarchy_.GetHierarchyEdge(edge_id);
+                    const VertexId next = forward ? edge.to : edge.from;
+                    const Weight candidate_weight = item.weight + edge.weight;
+                    if (!search.IsReached(next) || candidate_weight < search.weights[next]) {
+                        search.Reach(next, candidate_weight, edge_id);
+                    }
+                }
+            }
+
+            std::sort(settled.begin(), settled.end());
+            std::vector<std::pair<VertexId, Weight>>& label = vertex_labels[vertex];
+            std::vector<uint32_t>& parent_edges = vertex_parent_edges[vertex];
+            label.clear();
+            parent_edges.clear();
+            for (const VertexId hub : settled) {
+                label.push_back({ hub, search.weights[hub] });
+                parent_edges.push_back(static_cast<uint32_t>(search.prev_edges[hub]));
+            }
+        }
+
+        labels.offsets.assign(vertex_count + 1, 0);
+        for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+            labels.offsets[vertex + 1] = labels.offsets[vertex] + static_cast<uint32_t>(vertex_labels[vertex].size());
+        }
+        labels.hubs.clear();
+        labels.weights.clear();
+        labels.parent_edges.clear();
+        for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+            for (const auto& [hub, weight] : vertex_labels[vertex]) {
+                labels.hubs.push_back(static_cast<uint32_t>(hub));
+                labels.weights.push_back(weight);
+            }
+            labels.parent_edges.insert(labels.parent_edges.end(), vertex_parent_edges[vertex].begin(), vertex_parent_edges[vertex].end());
+        }
+    }
+
+    template <typename Weight>
+    std::optional<typename HubLabels<Weight>::Meeting> HubLabels<Weight>::FindMeeting(VertexId from, VertexId to) const {
+        std::optional<Meeting> result;
+        size_t forward_entry = forward_labels_.offsets[from];
+        size_t backward_entry = backward_labels_.offsets[to];
+        const size_t forward_end = forward_labels_.offsets[from + 1];
+        const size_t backward_end = backward_labels_.offsets[to + 1];
+        while (forward_entry < forward_end && backward_entry < backward_end) {
+            const uint32_t forward_hub = forward_labels_.hubs[forward_entry];
+            const uint32_t backward_hub = backward_labels_.hubs[backward_entry];
+            if (forward_hub < backward_hub) {
+                ++forward_entry;
+            }
+            else if (backward_hub < forward_hub) {
+                ++backward_entry;
+            }
+            else {
+                const Weight weight = forward_labels_.weights[forward_entry] + backward_labels_.weights[backward_entry];
+                if (!result || weight < result->weight) {
+                    result = Meeting{ weight, forward_entry, backward_entry };
+                }
+                ++forward_entry;
+                ++backward_entry;
+            }
+        }
+        return result;
+    }
+
+    template <typename Weight>
+    std::optional<Weight> HubLabels<Weight>::GetWeight(VertexId from, VertexId to) const {
+        const std::optional<Meeting> meeting = FindMeeting(from, to);
+        if (!meeting) {
+            return std::nullopt;
+        }
+        return meeting->weight;
+    }
+
+    template <typename Weight>
+    std::vector<EdgeId> HubLabels<Weight>::GetLabelPath(const Labels& labels, VertexId vertex, size_t entry, bool forward) const {
+        const auto label_begin = labels.hubs.begin() + labels.offsets[vertex];
+        const auto label_end = labels.hubs.begin() + labels.offsets[vertex + 1];
+        std::vector<EdgeId> result;
+        while (labels.parent_edges[entry] != NO_EDGE) {
+            const EdgeId edge_id = labels.parent_edges[entry];
+            result.push_back(edge_id);
+            const Edge<Weight> edge = hierarchy_.GetHierarchyEdge(edge_id);
+            const uint32_t previous_hub = static_cast<uint32_t>(forward ? edge.from : edge.to);
+            entry = std::lower_bound(label_begin, label_end, previous_hub) - labels.hubs.begin();
+        }
+        if (forward) {
+            std::reverse(result.begin(), result.end());
+        }
+        return result;
+    }
+
+    template <typename Weight>
+    std::optional<typename HubLabels<Weight>::RouteInfo> HubLabels<Weight>::BuildRoute(VertexId from, VertexId to) const {
+        const std::optional<Meeting> meeting = FindMeeting(from, to);
+        if (!meeting) {
+            return std::nullopt;
+        }
+        std::vector<EdgeId> edges;
+        for (const EdgeId edge_id : GetLabelPath(forward_labels_, from, meeting->forward_entry, true)) {
+            hierarchy_.UnpackEdge(edge_id, edges);
+        }
+        for (const EdgeId edge_id : GetLabelPath(backward_labels_, to, meeting->backward_entry, false)) {
+            hierarchy_.UnpackEdge(edge_id, edges);
+        }
+        return RouteInfo{ meeting->weight, std::move(edges) };
+    }
+
+}  // namespace graph
\ No newline at end of file
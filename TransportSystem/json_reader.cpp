@@ -10,6 +10,10 @@ namespace creator {
 	void Creator::ExecutingRequests(std::istream& input, std::ostream& output) {
 		reader.JSON_StatRequest(input, output);
 	}
+
+	void Creator::UpdateBase(std::istream& input) {
+		reader.JSON_UpdateRequest(input);
+	}
 }
 
 namespace readers {
@@ -45,7 +49,13 @@ namespace readers {
 			}
 		}
 
+		catalogue_.BuildStopBusIndex();
+		catalogue_.ComputeBusInfos();
+
 		std::shared_ptr<const transport_router::TransportRouter> router(new transport_router::TransportRouter(JSON_ReaderRoutingSetings(json::Document(query.GetRoot().AsDict().at("routing_settings"s))), catalogue_));
+#ifdef TRANSPORT_REPORT_ROUTER_STATS
+		std::cerr << "pruned rides: "s << router->GetPrunedEdgeCount() << std::endl;
+#endif
 
 		renderer::MapRender map_render(JSON_ReaderMapSettings(json::Document(query.GetRoot().AsDict().at("render_settings"s))));
 
@@ -100,6 +110,42 @@ namespace readers {
 		}
 	}
 
+	void Reader::JSON_UpdateRequest(std::istream& in) {
+		json::Document query = json::Load(in);
+		const std::string file_name = JSON_Serialization_Settings(json::Document(query.GetRoot().AsDict().at("serialization_settings"s)));
+		std::unique_ptr<transport_router::TransportRouter> router;
+		{
+			std::ifstream ifile(file_name, std::ios::binary);
+			router.reset(proto::Deserialization(catalogue_, map_render_, ifile));
+		}
+		if (!router) {
+			throw std::invalid_argument("base could not be read: "s + file_name);
+		}
+
+		if (query.GetRoot().AsDict().count("road_distance_updates"s) != 0) {
+			std::vector<std::pair<std::string_view, std::string_view>> changed_roads;
+			for (const auto& update : query.GetRoot().AsDict().at("road_distance_updates"s).AsArray()) {
+				if (update.AsDict().find("from") == update.AsDict().end()) {
+					throw std::invalid_argument("key not found: from");
+				}
+				if (update.AsDict().find("to") == update.AsDict().end()) {
+					throw std::invalid_argument("key not found: to");
+				}
+				if (update.AsDict().find("distance") == update.AsDict().end()) {
+					throw std::invalid_argument("key not found: distance");
+				}
+				catalogue_.SetLenghtBetweenStops({ update.AsDict().at("from"s).AsString(), update.AsDict().at("to"s).AsString() },
+					std::abs(update.AsDict().at("distance"s).AsInt()));
+				changed_roads.emplace_back(update.AsDict().at("from"s).AsString(), update.AsDict().at("to"s).AsString());
+			}
+			router->UpdateRoadDistances(changed_roads);
+			catalogue_.ComputeBusInfos();
+		}
+
+		std::ofstream ofile(file_name, std::ios::binary);
+		proto::Serialization(catalogue_, map_render_, *router, ofile);
+	}
+
 	void Reader::JSON_StatRequest(std::istream& in, std::ostream& out) {
 		json::Document query = json::Load(in);
 		std::ifstream ifile(JSON_Serialization_Settings(json::Document(query.GetRoot().AsDict().at("serialization_settings"s))), std::ios::binary);
@@ -118,7 +164,18 @@ namespace readers {
 
 		json::Array result;
 
+#ifdef TRANSPORT_REPORT_ROUTER_STATS
+		size_t route_count = 0;
+		size_t settled_vertices = 0;
+#endif
+#ifdef TRANSPORT_COUNT_ALLOCATIONS
+		// Allocations and requests of every type, answering included.
+		std::map<std::string, std::pair<size_t, size_t>> allocations;
+#endif
 		for (const auto& request : document.GetRoot().AsArray()) {
+#ifdef TRANSPORT_COUNT_ALLOCATIONS
+			const size_t allocation_count = allocation_counter::GetAllocationCount();
+#endif
 			if (request.AsDict().find("type"s) == request.AsDict().end()) {
 				throw std::invalid_argument("key not found: type"s);
 			}
@@ -142,10 +199,53 @@ namespace readers {
 				result.push_back(JSON_ResponseRequesMap(request_handler.RenderMap(), request.AsDict().at("id"s).AsInt()));
 			}
 			if (request.AsDict().at("type"s).AsString() == "Route"s) {
-				result.push_back(JSON_ResponseRequesRouter(request_handler, request.AsDict().at("from"s).AsString(), request.AsDict().at("to"s).AsString(), request.AsDict().at("id"s).AsInt()));
+				graph::SearchStats stats;
+				result.push_back(JSON_ResponseRequesRouter(request_handler, request.AsDict().at("from"s).AsString(), request.AsDict().at("to"s).AsString(), request.AsDict().at("id"s).AsInt(), stats));
+#ifdef TRANSPORT_REPORT_ROUTER_STATS
+				route_count++;
+				settled_vertices += stats.settled_vertices;
+#endif
 			}
-
+			if (request.AsDict().at("type"s).AsString() == "RouteMatrix"s) {
+				if (request.AsDict().find("from"s) == request.AsDict().end()) {
+					throw std::invalid_argument("key not found: from"s);
+				}
+				if (request.AsDict().find("to"s) == request.AsDict().end()) {
+					throw std::invalid_argument("key not found: to"s);
+				}
+				result.push_back(JSON_ResponseRequestRouteMatrix(request_handler, request.AsDict().at("from"s).AsArray(), request.AsDict().at("to"s).AsArray(), request.AsDict().at("id"s).AsInt()));
+			}
+			if (request.AsDict().at("type"s).AsString() == "Isochrone"s) {
+				if (request.AsDict().find("stop"s) == request.AsDict().end()) {
+					throw std::invalid_argument("key not found: stop"s);
+				}
+				if (request.AsDict().find("max_time"s) == request.AsDict().end()) {
+					throw std::invalid_argument("key not found: max_time"s);
+				}
+				result.push_back(JSON_ResponseRequestIsochrone(request_handler, request.AsDict().at("stop"s).AsString(), request.AsDict().at("max_time"s).AsDouble(), request.AsDict().at("id"s).AsInt()));
+			}
+#ifdef TRANSPORT_COUNT_ALLOCATIONS
+			auto& [type_allocations, type_requests] = allocations[request.AsDict().at("type"s).AsString()];
+			type_allocations += allocation_counter::GetAllocationCount() - allocation_count;
+			++type_requests;
+#endif
+		}
+#ifdef TRANSPORT_COUNT_ALLOCATIONS
+		for (const auto& [type, counts] : allocations) {
+			std::cerr << "allocations "s << type << ": "s << counts.first << " in "s << counts.second << " requests, "s
+				<< static_cast<double>(counts.first) / counts.second << " per request"s << std::endl;
+		}
+#endif
+#ifdef TRANSPORT_REPORT_ROUTER_STATS
+		if (const transport_router::CacheStats cache_stats = router->GetRouteCacheStats(); cache_stats.hits + cache_stats.misses != 0) {
+			std::cerr << "route cache: "s << cache_stats.hits << " hits, "s << cache_stats.misses << " misses, "s
+				<< cache_stats.evictions << " evictions"s << std::endl;
+		}
+		if (route_count != 0) {
+			std::cerr << "settled vertices: "s << settled_vertices << " in "s << route_count << " Route requests, "s
+				<< static_cast<double>(settled_vertices) / route_count << " per request"s << std::endl;
 		}
+#endif
 		Print(json::Document{ json::Node {result} }, out);
 	}
 
@@ -174,8 +274,8 @@ namespace readers {
 		if (stop_info.exists) {
 			json::Builder builder;
 			builder.StartDict().Key("buses"s).StartArray();
-			for (const auto& bus : stop_info.buses) {
-				builder.Value(std::string(bus));
+			for (const uint32_t bus_id : stop_info.buses) {
+				builder.Value(catalogue_.GetBus(bus_id).name);
 			}
 			builder.EndArray();
 			builder.Key("request_id"s).Value(id).EndDict();
@@ -203,14 +303,14 @@ namespace readers {
 		return json::Node{ json::Dict{ { "map", render_node }, { "request_id", id_node } } };
 	}
 
-	json::Node Reader::JSON_ResponseRequesRouter(const RequestHandler& request_handler, const std::string& from, const std::string& to, int id) {
-		std::optional<transport_router::RouteInfo> info_ort = request_handler.GetRouteStat(from, to);
+	json::Node Reader::JSON_ResponseRequesRouter(const RequestHandler& request_handler, const std::string& from, const std::string& to, int id, graph::SearchStats& stats) {
+		const std::shared_ptr<const transport_router::RouteInfo> info_ort = request_handler.GetRouteStat(from, to, &stats);
 
 		if (!info_ort) {
 			return json::Builder().StartDict().Key("error_message"s).Value("not found"s).Key("request_id"s).Value(id).EndDict().Build();
 		}
 
-		transport_router::RouteInfo info = info_ort.value();
+		const transport_router::RouteInfo& info = *info_ort;
 
 		json::Builder builder;
 		builder.StartDict().Key("items"s).StartArray();
@@ -236,6 +336,51 @@ namespace readers {
 			.Key("total_time"s).Value(info.GetTotalTime()).EndDict().Build();
 	}
 
+	json::Node Reader::JSON_ResponseRequestRouteMatrix(const RequestHandler& request_handler, const json::Array& from, const json::Array& to, int id) {
+		std::vector<std::string_view> from_stops;
+		std::vector<std::string_view> to_stops;
+		for (const auto& [nodes, stops] : { std::pair{ &from, &from_stops }, std::pair{ &to, &to_stops } }) {
+			for (const json::Node& node : *nodes) {
+				if (!catalogue_.StopAvailability(node.AsString())) {
+					return json::Builder().StartDict().Key("error_message"s).Value("not found"s).Key("request_id"s).Value(id).EndDict().Build();
+				}
+				stops->push_back(node.AsString());
+			}
+		}
+
+		json::Builder builder;
+		builder.StartDict().Key("request_id"s).Value(id).Key("total_times"s).StartArray();
+		for (const auto& row : request_handler.GetRouteMatrixStat(from_stops, to_stops)) {
+			builder.StartArray();
+			for (const std::optional<double>& total_time : row) {
+				if (total_time) {
+					builder.Value(*total_time);
+				}
+				else {
+					builder.Value(nullptr);
+				}
+			}
+			builder.EndArray();
+		}
+		return builder.EndArray().EndDict().Build();
+	}
+
+	json::Node Reader::JSON_ResponseRequestIsochrone(const RequestHandler& request_handler, const std::string& stop_name, double max_time, int id) {
+		if (!catalogue_.StopAvailability(stop_name)) {
+			return json::Builder().StartDict().Key("error_message"s).Value("not found"s).Key("request_id"s).Value(id).EndDict().Build();
+		}
+
+		json::Builder builder;
+		builder.StartDict().Key("request_id"s).Value(id).Key("stops"s).StartArray();
+		for (const auto& [name, time] : request_handler.GetIsochroneStat(stop_name, max_time)) {
+			builder.StartDict().
+				Key("stop_name"s).Value(std::string(name)).
+				Key("time"s).Value(time)
+				.EndDict();
+		}
+		return builder.EndArray().EndDict().Build();
+	}
+
 	transport_router::RoutingSettings Reader::JSON_ReaderRoutingSetings(const json::Document& document) {
 		if (document.GetRoot().AsDict().find("bus_wait_time"s) == document.GetRoot().AsDict().end()) {
 			throw std::invalid_argument("key not found: bus wait time"s);
@@ -243,8 +388,71 @@ namespace readers {
 		if (document.GetRoot().AsDict().find("bus_velocity"s) == document.GetRoot().AsDict().end()) {
 			throw std::invalid_argument("key not found: bus velocity"s);
 		}
-		return { static_cast<unsigned short int>(document.GetRoot().AsDict().at("bus_wait_time"s).AsInt()),
-				 static_cast<unsigned short int>(document.GetRoot().AsDict().at("bus_velocity"s).AsInt()) };
+		transport_router::RoutingSettings result(static_cast<unsigned short int>(document.GetRoot().AsDict().at("bus_wait_time"s).AsInt()),
+			static_cast<unsigned short int>(document.GetRoot().AsDict().at("bus_velocity"s).AsInt()));
+
+		if (document.GetRoot().AsDict().count("routing_algorithm"s) != 0) {
+			const std::string& algorithm = document.GetRoot().AsDict().at("routing_algorithm"s).AsString();
+			if (algorithm == "all_pairs"s) {
+				result.algorithm_ = transport_router::RoutingAlgorithm::ALL_PAIRS;
+			}
+			else if (algorithm == "dijkstra"s) {
+				result.algorithm_ = transport_router::RoutingAlgorithm::DIJKSTRA;
+			}
+			else if (algorithm == "contraction_hierarchies"s) {
+				result.algorithm_ = transport_router::RoutingAlgorithm::CONTRACTION_HIERARCHIES;
+			}
+			else if (algorithm == "a_star"s) {
+				result.algorithm_ = transport_router::RoutingAlgorithm::A_STAR;
+			}
+			else if (algorithm == "raptor"s) {
+				result.algorithm_ = transport_router::RoutingAlgorithm::RAPTOR;
+			}
+			else if (algorithm == "bidirectional_dijkstra"s) {
+				result.algorithm_ = transport_router::RoutingAlgorithm::BIDIRECTIONAL_DIJKSTRA;
+			}
+			else if (algorithm == "alt"s) {
+				result.algorithm_ = transport_router::RoutingAlgorithm::ALT;
+			}
+			else if (algorithm == "hub_labels"s) {
+				result.algorithm_ = transport_router::RoutingAlgorithm::HUB_LABELS;
+			}
+			else {
+				throw std::invalid_argument("unknown routing algorithm: "s + algorithm);
+			}
+		}
+		if (document.GetRoot().AsDict().count("router_threads"s) != 0) {
+			const int threads = document.GetRoot().AsDict().at("router_threads"s).AsInt();
+			if (threads < 1) {
+				throw std::invalid_argument("router_threads must be at least 1"s);
+			}
+			result.threads_ = static_cast<unsigned int>(threads);
+		}
+		if (document.GetRoot().AsDict().count("route_cache_capacity"s) != 0) {
+			const int cache_capacity = document.GetRoot().AsDict().at("route_cache_capacity"s).AsInt();
+			if (cache_capacity < 0) {
+				throw std::invalid_argument("route_cache_capacity must not be negative"s);
+			}
+			result.route_cache_capacity_ = static_cast<size_t>(cache_capacity);
+		}
+		if (document.GetRoot().AsDict().count("lazy_router"s) != 0) {
+			result.lazy_router_ = document.GetRoot().AsDict().at("lazy_router"s).AsBool();
+		}
+		if (document.GetRoot().AsDict().count("router_memory_budget"s) != 0) {
+			const int memory_budget = document.GetRoot().AsDict().at("router_memory_budget"s).AsInt();
+			if (memory_budget < 0) {
+				throw std::invalid_argument("router_memory_budget must not be negative"s);
+			}
+			result.router_memory_budget_ = static_cast<size_t>(memory_budget);
+		}
+		if (document.GetRoot().AsDict().count("landmarks_count"s) != 0) {
+			const int landmarks_count = document.GetRoot().AsDict().at("landmarks_count"s).AsInt();
+			if (landmarks_count < 0) {
+				throw std::invalid_argument("landmarks_count must not be negative"s);
+			}
+			result.landmarks_count_ = static_cast<unsigned int>(landmarks_count);
+		}
+		return result;
 	}
 
 	renderer::MapSettings Reader::JSON_ReaderMapSettings(const json::Document& document) {
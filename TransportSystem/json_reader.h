@@ -6,7 +6,11 @@
 
 #include <optional>
 #include <fstream>
+#include <memory>
+#include <map>
+#include <iostream>
 
+#include "allocation_counter.h"
 #include "json.h"
 #include "domain.h"
 #include "transport_catalogue.h"
@@ -27,6 +31,9 @@ namespace readers {
 
 		void JSON_StatRequest(std::istream& in, std::ostream& out);
 
+		// Applies road_distance_updates to the base named in serialization_settings and writes it back.
+		void JSON_UpdateRequest(std::istream& in);
+
 	private:
 		std::string JSON_Serialization_Settings(const json::Document& document);
 
@@ -44,7 +51,11 @@ namespace readers {
 
 		json::Node JSON_ResponseRequesMap(const svg::Document& map, int id);
 
-		json::Node JSON_ResponseRequesRouter(const RequestHandler& request_handler, const std::string& from, const std::string& to, int id);
+		json::Node JSON_ResponseRequesRouter(const RequestHandler& request_handler, const std::string& from, const std::string& to, int id, graph::SearchStats& stats);
+
+		json::Node JSON_ResponseRequestRouteMatrix(const RequestHandler& request_handler, const json::Array& from, const json::Array& to, int id);
+
+		json::Node JSON_ResponseRequestIsochrone(const RequestHandler& request_handler, const std::string& stop_name, double max_time, int id);
 
 		svg::Color JSON_ReaderColor(const json::Node& node);
 
@@ -63,6 +74,8 @@ namespace creator {
 
 		void ExecutingRequests(std::istream& input, std::ostream& output);
 
+		void UpdateBase(std::istream& input);
+
 	private:
 		TransportCatalogue catalogue_ = {};
 		renderer::MapRender map_render_ = {};
@@ -0,0 +1,174 @@
+#pragma once
+
+#include "graph.h"
+
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+    // Lower bounds of route weights for goal-directed search (ALT). For every landmark L the weights of
+    // the shortest routes from L and to L are known, and by the triangle inequality
+    //     d(v, t) >= d(L, t) - d(L, v)  and  d(v, t) >= d(v, L) - d(t, L).
+    // Memory is linear in the number of vertices for every landmark.
+    template <typename Weight>
+    class Landmarks {
+    private:
+        using Graph = DirectedWeightedGraph<Weight>;
+
+    public:
+        static constexpr Weight NO_ROUTE = std::numeric_limits<Weight>::has_infinity
+            ? std::numeric_limits<Weight>::infinity()
+            : std::numeric_limits<Weight>::max();
+
+        // Picks up to landmark_count landmarks among candidates by farthest-point selection: every next
+        // landmark is the candidate farthest from the closest landmark chosen so far, where candidates
+        // unreachable from all of them count as the farthest ones.
+        Landmarks(const Graph& graph, const std::vector<VertexId>& candidates, size_t landmark_count);
+
+        Landmarks(const Graph& graph, std::vector<VertexId>&& landmarks, std::vector<Weight>&& forward_weights,
+            std::vector<Weight>&& backward_weights);
+
+        Weight GetLowerBound(VertexId from, VertexId to) const;
+
+        const std::vector<VertexId>& GetLandmarks() const {
+            return landmarks_;
+        }
+
+        // Row-major: the weights of landmark i occupy [i * GetVertexCount(), (i + 1) * GetVertexCount()).
+        const std::vector<Weight>& GetForwardWeights() const {
+            return forward_weights_;
+        }
+
+        const std::vector<Weight>& GetBackwardWeights() const {
+            return backward_weights_;
+        }
+
+    private:
+        // Weights of the shortest routes from source, or to source over the incoming edges if backward.
+        std::vector<Weight> ComputeWeights(VertexId source, bool backward) const;
+
+        static constexpr Weight ZERO_WEIGHT{};
+
+        const Graph& graph_;
+        std::vector<VertexId> landmarks_;
+        std::vector<Weight> forward_weights_;
+        std::vector<Weight> backward_weights_;
+    };
+
+    template <typename Weight>
+    Landmarks<Weight>::Landmarks(const Graph& graph, const std::vector<VertexId>& candidates, size_t landmark_count)
+        : graph_(graph)
+    {
+        if (candidates.empty()) {
+            return;
+        }
+
+        // Distance of every candidate to the closest landmark; the selection starts from the reachable
+        // candidate farthest from the first one rather than from the first one itself.
+        std::vector<Weight> closest_weights(candidates.size(), NO_ROUTE);
+        const std::vector<Weight> seed_weights = ComputeWeights(candidates.front(), false);
+        auto pick_farthest = [&](const std::vector<Weight>& weights) {
+            size_t farthest = 0;
+            for (size_t i = 0; i < candidates.size(); ++i) {
+                if (weights[i] > weights[farthest]) {
+                    farthest = i;
+                }
+            }
+            return farthest;
+        };
+        for (size_t i = 0; i < candidates.size(); ++i) {
+            closest_weights[i] = seed_weights[candidates[i]] != NO_ROUTE ? seed_weights[candidates[i]] : ZERO_WEIGHT;
+        }
+        size_t next_landmark = pick_farthest(closest_weights);
+        std::fill(closest_weights.begin(), closest_weights.end(), NO_ROUTE);
+
+        const size_t vertex_count = graph.GetVertexCount();
+        while (landmarks_.size() < std::min(landmark_count, candidates.size())) {
+            const VertexId landmark = candidates[next_landmark];
+            landmarks_.push_back(landmark);
+            const std::vector<Weight> forward_weights = ComputeWeights(landmark, false);
+            const std::vector<Weight> backward_weights = ComputeWeights(landmark, true);
+            forward_weights_.insert(forward_weights_.end(), forward_weights.begin(), forward_weights.end());
+            backward_weights_.insert(backward_weights_.end(), backward_weights.begin(), backward_weights.end());
+
+            for (size_t i = 0; i < candidates.size(); ++i) {
+                closest_weights[i] = std::min(closest_weights[i], forward_weights[candidates[i]]);
+            }
+            next_landmark = pick_farthest(closest_weights);
+            if (closest_weights[next_landmark] == ZERO_WEIGHT) {
+                break;
+            }
+        }
+        forward_weights_.resize(landmarks_.size() * vertex_count);
+        backward_weights_.resize(landmarks_.size() * vertex_count);
+    }
+
+    template <typename Weight>
+    Landmarks<Weight>::Landmarks(const Graph& graph, std::vector<VertexId>&& landmarks, std::vector<Weight>&& forward_weights,
+        std::vector<Weight>&& backward_weights)
+        : graph_(graph)
+        , landmarks_(std::move(landmarks))
+        , forward_weights_(std::move(forward_weights))
+        , backward_weights_(std::move(backward_weights)) {
+    }
+
+    template <typename Weight>
+    Weight Landmarks<Weight>::GetLowerBound(VertexId from, VertexId to) const {
+        const size_t vertex_count = graph_.GetVertexCount();
+        Weight result = ZERO_WEIGHT;
+        for (size_t i = 0; i < landmarks_.size(); ++i) {
+            // A landmark that does not reach both vertices (or is not reached from both) says nothing.
+            const Weight* forward_weights = forward_weights_.data() + i * vertex_count;
+            if (forward_weights[from] != NO_ROUTE && forward_weights[to] != NO_ROUTE) {
+                result = std::max(result, forward_weights[to] - forward_weights[from]);
+            }
+            const Weight* backward_weights = backward_weights_.data() + i * vertex_count;
+            if (backward_weights[from] != NO_ROUTE && backward_weights[to] != NO_ROUTE) {
+                result = std::max(result, backward_weights[from] - backward_weights[to]);
+            }
+        }
+        return result;
+    }
+
+    template <typename Weight>
+    std::vector<Weight> Landmarks<Weight>::ComputeWeights(VertexId source, bool backward) const {
+        std::vector<Weight> weights(graph_.GetVertexCount(), NO_ROUTE);
+        using QueueItem = std::pair<Weight, VertexId>;
+        std::vector<QueueItem> heap;
+        weights[source] = ZERO_WEIGHT;
+        heap.push_back({ ZERO_WEIGHT, source });
+        auto relax = [&](Weight weight, EdgeId edge_id, VertexId next_vertex) {
+            const Weight candidate_weight = weight + graph_.GetEdge(edge_id).weight;
+            if (candidate_weight < weights[next_vertex]) {
+                weights[next_vertex] = candidate_weight;
+                heap.push_back({ candidate_weight, next_vertex });
+                std::push_heap(heap.begin(), heap.end(), std::greater<QueueItem>{});
+            }
+        };
+        while (!heap.empty()) {
+            std::pop_heap(heap.begin(), heap.end(), std::greater<QueueItem>{});
+            const auto [weight, vertex] = heap.back();
+            heap.pop_back();
+            if (weights[vertex] < weight) {
+                continue;
+            }
+            if (backward) {
+                for (const EdgeId edge_id : graph_.GetIncomingEdges(vertex)) {
+                    relax(weight, edge_id, graph_.GetEdge(edge_id).from);
+                }
+            }
+            else {
+                for (const EdgeId edge_id : graph_.GetIncidentEdges(vertex)) {
+                    relax(weight, edge_id, graph_.GetEdge(edge_id).to);
+                }
+            }
+        }
+        return weights;
+    }
+
+}  // namespace graph
\ No newline at end of file
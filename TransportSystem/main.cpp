@@ -9,7 +9,7 @@ using namespace transportcatalogue;
 using namespace std;
 
 void PrintUsage(std::ostream& stream = std::cerr) {
-    stream << "Usage: transport_catalogue [make_base|process_requests]\n"sv;
+    stream << "Usage: transport_catalogue [make_base|process_requests|update_base]\n"sv;
 }
 
 //int main(int argc, char* argv[]) {
@@ -70,6 +70,10 @@ int main(int argc, char* argv[]) {
         creator::Creator creator;
         creator.ExecutingRequests(std::cin, std::cout);
     }
+    else if (mode == "update_base"sv) {
+        creator::Creator creator;
+        creator.UpdateBase(std::cin);
+    }
     else {
         PrintUsage();
         return 1;
@@ -0,0 +1,90 @@
+#include "min_plus_kernel.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+// Relaxes rows of a route table through pivot rows the way the blocked Floyd-Warshall of graph::Router
+// does, once with the generic branching loop and once with the dispatched kernel, and compares the results.
+// Usage: min_plus_benchmark [vertex_count] [row_count] [pivot_count]
+
+namespace {
+
+    struct Table {
+        std::vector<double> weights;
+        std::vector<uint32_t> prev_edges;
+    };
+
+    // Rows of a sparse graph: every vertex starts with a few finite weights, the rest has no route yet.
+    Table MakeTable(size_t vertex_count, size_t row_count, std::mt19937& generator) {
+        const double no_route = std::numeric_limits<double>::infinity();
+        Table result{ std::vector<double>(row_count * vertex_count, no_route),
+            std::vector<uint32_t>(row_count * vertex_count, std::numeric_limits<uint32_t>::max()) };
+        std::uniform_int_distribution<size_t> vertex(0, vertex_count - 1);
+        std::uniform_real_distribution<double> weight(1., 100.);
+        for (size_t row = 0; row < row_count; ++row) {
+            result.weights[row * vertex_count + row % vertex_count] = 0.;
+            for (size_t edge = 0; edge < vertex_count / 8; ++edge) {
+                const size_t cell = row * vertex_count + vertex(generator);
+                result.weights[cell] = weight(generator);
+                result.prev_edges[cell] = static_cast<uint32_t>(cell);
+            }
+        }
+        return result;
+    }
+
+    template <typename Relax>
+    double Measure(Table& table, size_t vertex_count, size_t row_count, size_t pivot_count, const Relax& relax) {
+        const auto start = std::chrono::steady_clock::now();
+        for (size_t pivot = 0; pivot < pivot_count; ++pivot) {
+            const size_t pivot_row = pivot % row_count;
+            const size_t pivot_vertex = pivot_row % vertex_count;
+            for (size_t row = 0; row < row_count; ++row) {
+                const double weight_from = table.weights[row * vertex_count + pivot_vertex];
+                if (row == pivot_row || weight_from == std::numeric_limits<double>::infinity()) {
+                    continue;
+                }
+                relax(weight_from, table.prev_edges[row * vertex_count + pivot_vertex],
+                    table.weights.data() + pivot_row * vertex_count, table.prev_edges.data() + pivot_row * vertex_count,
+                    table.weights.data() + row * vertex_count, table.prev_edges.data() + row * vertex_count, vertex_count);
+            }
+        }
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    const size_t vertex_count = argc > 1 ? std::stoul(argv[1]) : 5000;
+    const size_t row_count = argc > 2 ? std::stoul(argv[2]) : 1000;
+    const size_t pivot_count = argc > 3 ? std::stoul(argv[3]) : 200;
+    if (vertex_count == 0 || row_count == 0) {
+        std::cerr << "vertex_count and row_count must be positive" << std::endl;
+        return 1;
+    }
+
+    std::mt19937 generator(42);
+    Table generic_table = MakeTable(vertex_count, row_count, generator);
+    Table kernel_table = generic_table;
+
+    const double generic_time = Measure(generic_table, vertex_count, row_count, pivot_count,
+        [](double weight_from, uint32_t prev_edge_from, const double* pivot_weights, const uint32_t* pivot_prev_edges,
+            double* weights, uint32_t* prev_edges, size_t count) {
+            graph::RelaxRowMinPlus<double>(weight_from, prev_edge_from, pivot_weights, pivot_prev_edges, weights, prev_edges, count);
+        });
+    const double kernel_time = Measure(kernel_table, vertex_count, row_count, pivot_count,
+        [](double weight_from, uint32_t prev_edge_from, const double* pivot_weights, const uint32_t* pivot_prev_edges,
+            double* weights, uint32_t* prev_edges, size_t count) {
+            graph::RelaxRowMinPlus(weight_from, prev_edge_from, pivot_weights, pivot_prev_edges, weights, prev_edges, count);
+        });
+
+    const bool is_same = generic_table.weights == kernel_table.weights && generic_table.prev_edges == kernel_table.prev_edges;
+    std::cout << vertex_count << " vertices, " << row_count << " rows, " << pivot_count << " pivots\n"
+        << "generic loop: " << generic_time << " ms\n"
+        << "kernel:       " << kernel_time << " ms (" << generic_time / kernel_time << "x)\n"
+        << "tables " << (is_same ? "match" : "DIFFER") << std::endl;
+    return is_same ? EXIT_SUCCESS : EXIT_FAILURE;
+}
\ No newline at end of file
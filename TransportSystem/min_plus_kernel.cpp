@@ -0,0 +1,109 @@
+#include "min_plus_kernel.h"
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define GRAPH_MIN_PLUS_AVX2
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define GRAPH_TARGET_AVX2
+#else
+#define GRAPH_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+namespace graph {
+
+    namespace {
+
+        // With +infinity as "no route" the branches of the generic loop disappear: an infinite pivot weight
+        // gives an infinite candidate, which is never strictly smaller, and any finite candidate is smaller
+        // than an infinite current weight.
+        void RelaxRowMinPlusScalar(double weight_from, uint32_t prev_edge_from, const double* pivot_weights,
+            const uint32_t* pivot_prev_edges, double* weights, uint32_t* prev_edges, size_t count) {
+            for (size_t j = 0; j < count; ++j) {
+                const double candidate_weight = weight_from + pivot_weights[j];
+                const uint32_t candidate_prev_edge = pivot_prev_edges[j] != std::numeric_limits<uint32_t>::max() ? pivot_prev_edges[j] : prev_edge_from;
+                const bool is_shorter = candidate_weight < weights[j];
+                weights[j] = is_shorter ? candidate_weight : weights[j];
+                prev_edges[j] = is_shorter ? candidate_prev_edge : prev_edges[j];
+            }
+        }
+
+#ifdef GRAPH_MIN_PLUS_AVX2
+        // Eight cells per iteration: two registers of four weights and one of eight last edges, updated
+        // through the comparison masks.
+        GRAPH_TARGET_AVX2
+        void RelaxRowMinPlusAvx2(double weight_from, uint32_t prev_edge_from, const double* pivot_weights,
+            const uint32_t* pivot_prev_edges, double* weights, uint32_t* prev_edges, size_t count) {
+            const __m256d from = _mm256_set1_pd(weight_from);
+            const __m256i from_prev_edge = _mm256_set1_epi32(static_cast<int>(prev_edge_from));
+            const __m256i no_edge = _mm256_set1_epi32(-1);
+            // Takes the low halves of the 64-bit lanes, i.e. one 32-bit mask lane per weight.
+            const __m256i mask_lanes = _mm256_setr_epi32(0, 2, 4, 6, 0, 2, 4, 6);
+
+            size_t j = 0;
+            for (; j + 8 <= count; j += 8) {
+                const __m256d low_weights = _mm256_loadu_pd(weights + j);
+                const __m256d high_weights = _mm256_loadu_pd(weights + j + 4);
+                const __m256d low_candidates = _mm256_add_pd(from, _mm256_loadu_pd(pivot_weights + j));
+                const __m256d high_candidates = _mm256_add_pd(from, _mm256_loadu_pd(pivot_weights + j + 4));
+                const __m256d low_mask = _mm256_cmp_pd(low_candidates, low_weights, _CMP_LT_OQ);
+                const __m256d high_mask = _mm256_cmp_pd(high_candidates, high_weights, _CMP_LT_OQ);
+                if (_mm256_movemask_pd(_mm256_or_pd(low_mask, high_mask)) == 0) {
+                    continue;
+                }
+                _mm256_storeu_pd(weights + j, _mm256_blendv_pd(low_weights, low_candidates, low_mask));
+                _mm256_storeu_pd(weights + j + 4, _mm256_blendv_pd(high_weights, high_candidates, high_mask));
+
+                const __m256i edge_mask = _mm256_blend_epi32(
+                    _mm256_permutevar8x32_epi32(_mm256_castpd_si256(low_mask), mask_lanes),
+                    _mm256_permutevar8x32_epi32(_mm256_castpd_si256(high_mask), mask_lanes), 0xF0);
+                const __m256i pivot_edges = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pivot_prev_edges + j));
+                const __m256i candidate_edges = _mm256_blendv_epi8(pivot_edges, from_prev_edge, _mm256_cmpeq_epi32(pivot_edges, no_edge));
+                const __m256i current_edges = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(prev_edges + j));
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(prev_edges + j), _mm256_blendv_epi8(current_edges, candidate_edges, edge_mask));
+            }
+            RelaxRowMinPlusScalar(weight_from, prev_edge_from, pivot_weights + j, pivot_prev_edges + j, weights + j, prev_edges + j, count - j);
+        }
+
+        bool HasAvx2() {
+#ifdef _MSC_VER
+            int info[4];
+            __cpuid(info, 0);
+            if (info[0] < 7) {
+                return false;
+            }
+            __cpuid(info, 1);
+            const bool has_osxsave = (info[2] & (1 << 27)) != 0;
+            const bool has_avx = (info[2] & (1 << 28)) != 0;
+            if (!has_osxsave || !has_avx || (_xgetbv(0) & 0x6) != 0x6) {
+                return false;
+            }
+            __cpuidex(info, 7, 0);
+            return (info[1] & (1 << 5)) != 0;
+#else
+            return __builtin_cpu_supports("avx2");
+#endif
+        }
+#endif
+
+        using RelaxRowFunction = void (*)(double, uint32_t, const double*, const uint32_t*, double*, uint32_t*, size_t);
+
+        RelaxRowFunction SelectRelaxRow() {
+#ifdef GRAPH_MIN_PLUS_AVX2
+            if (HasAvx2()) {
+                return RelaxRowMinPlusAvx2;
+            }
+#endif
+            return RelaxRowMinPlusScalar;
+        }
+
+    }  // namespace
+
+    void RelaxRowMinPlus(double weight_from, uint32_t prev_edge_from, const double* pivot_weights,
+        const uint32_t* pivot_prev_edges, double* weights, uint32_t* prev_edges, size_t count) {
+        static const RelaxRowFunction relax_row = SelectRelaxRow();
+        relax_row(weight_from, prev_edge_from, pivot_weights, pivot_prev_edges, weights, prev_edges, count);
+    }
+
+}  // namespace graph
\ No newline at end of file
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+namespace graph {
+
+    // One row of a min-plus product: weights[j] = min(weights[j], weight_from + pivot_weights[j]) for every
+    // j below count, taking the route's last edge from the pivot row, or prev_edge_from when the pivot row
+    // holds an empty route. No route is +infinity (or max() for types without one) and no edge is UINT32_MAX,
+    // as in RouteMatrix; weight_from itself must be a route. A candidate wins only if it is strictly smaller,
+    // so the result does not depend on the implementation.
+    template <typename Weight>
+    void RelaxRowMinPlus(Weight weight_from, uint32_t prev_edge_from, const Weight* pivot_weights,
+        const uint32_t* pivot_prev_edges, Weight* weights, uint32_t* prev_edges, size_t count) {
+        constexpr Weight no_route = std::numeric_limits<Weight>::has_infinity
+            ? std::numeric_limits<Weight>::infinity()
+            : std::numeric_limits<Weight>::max();
+        for (size_t j = 0; j < count; ++j) {
+            if (pivot_weights[j] == no_route) {
+                continue;
+            }
+            const Weight candidate_weight = weight_from + pivot_weights[j];
+            if (weights[j] == no_route || candidate_weight < weights[j]) {
+                weights[j] = candidate_weight;
+                prev_edges[j] = pivot_prev_edges[j] != std::numeric_limits<uint32_t>::max() ? pivot_prev_edges[j] : prev_edge_from;
+            }
+        }
+    }
+
+    // Picks an AVX2 implementation at runtime when the processor supports it.
+    void RelaxRowMinPlus(double weight_from, uint32_t prev_edge_from, const double* pivot_weights,
+        const uint32_t* pivot_prev_edges, double* weights, uint32_t* prev_edges, size_t count);
+
+}  // namespace graph
\ No newline at end of file
@@ -0,0 +1,185 @@
+#include "raptor_router.h"
+
+#include <algorithm>
+#include <iterator>
+
+namespace transport_router {
+
+	RaptorRouter::RaptorRouter(const transportcatalogue::TransportCatalogue& db, double wait_time, const SegmentTime& segment_time) :
+		wait_time_(wait_time) {
+		for (const transportcatalogue::Stop& stop : db.GetAllStops()) {
+			stops_.push_back(&stop);
+		}
+
+		for (const transportcatalogue::Bus& bus : db.GetAllBuses()) {
+			std::vector<uint32_t> stops;
+			stops.reserve(bus.stops.size());
+			for (const transportcatalogue::Stop* stop : bus.stops) {
+				stops.push_back(stop->id);
+			}
+			std::vector<uint32_t> reversed_stops(stops.rbegin(), stops.rend());
+			AddPattern(bus, std::move(stops), segment_time);
+			if (!bus.is_loop_trip) {
+				AddPattern(bus, std::move(reversed_stops), segment_time);
+			}
+		}
+
+		stop_pattern_offsets_.assign(stops_.size() + 1, 0);
+		for (const Pattern& pattern : patterns_) {
+			for (uint32_t stop : pattern.stops) {
+				stop_pattern_offsets_[stop + 1]++;
+			}
+		}
+		for (size_t stop = 0; stop < stops_.size(); stop++) {
+			stop_pattern_offsets_[stop + 1] += stop_pattern_offsets_[stop];
+		}
+		stop_patterns_.resize(stop_pattern_offsets_.back());
+		std::vector<size_t> next_entry(stop_pattern_offsets_.begin(), std::prev(stop_pattern_offsets_.end()));
+		for (uint32_t pattern = 0; pattern < patterns_.size(); pattern++) {
+			for (uint32_t position = 0; position < patterns_[pattern].stops.size(); position++) {
+				stop_patterns_[next_entry[patterns_[pattern].stops[position]]++] = { pattern, position };
+			}
+		}
+	}
+
+	void RaptorRouter::AddPattern(const transportcatalogue::Bus& bus, std::vector<uint32_t>&& stops, const SegmentTime& segment_time) {
+		Pattern pattern{ &bus, std::move(stops), {} };
+		for (size_t i = 1; i < pattern.stops.size(); i++) {
+			pattern.segment_times.push_back(segment_time(stops_[pattern.stops[i - 1]], stops_[pattern.stops[i]]));
+		}
+		patterns_.push_back(std::move(pattern));
+	}
+
+	void RaptorRouter::QueryBuffers::Prepare(size_t stop_count, size_t pattern_count) {
+		if (stamps.size() < stop_count) {
+			labels.resize(stop_count);
+			parents.resize(stop_count);
+			stamps.resize(stop_count, 0);
+			is_marked.resize(stop_count, false);
+		}
+		if (first_positions.size() < pattern_count) {
+			first_positions.resize(pattern_count, NO_POSITION);
+		}
+		if (++current_stamp == 0) {
+			std::fill(stamps.begin(), stamps.end(), 0);
+			current_stamp = 1;
+		}
+		marked_stops.clear();
+		queued_patterns.clear();
+	}
+
+	std::optional<RaptorRouter::Journey> RaptorRouter::BuildRoute(const transportcatalogue::Stop* from, const transportcatalogue::Stop* to, graph::SearchStats* stats) const {
+		const uint32_t source = from->id;
+		const uint32_t target = to->id;
+
+		QueryBuffers& buffers = GetQueryBuffers();
+		const size_t improved_labels = Search(buffers, source, target);
+		if (stats != nullptr) {
+			stats->settled_vertices = improved_labels;
+		}
+
+		if (!buffers.IsReached(target)) {
+			return std::nullopt;
+		}
+		Journey result{ buffers.labels[target], {} };
+		for (uint32_t stop = target; stop != source;) {
+			const Parent& parent = buffers.parents[stop];
+			const Pattern& pattern = patterns_[parent.pattern];
+			stop = pattern.stops[parent.board_position];
+			result.legs.push_back({ stops_[stop], pattern.bus, parent.alight_position - parent.board_position, parent.ride_time });
+		}
+		std::reverse(result.legs.begin(), result.legs.end());
+		return result;
+	}
+
+	std::vector<std::optional<double>> RaptorRouter::BuildTimes(const transportcatalogue::Stop* from, const std::vector<const transportcatalogue::Stop*>& targets) const {
+		QueryBuffers& buffers = GetQueryBuffers();
+		Search(buffers, from->id, NO_STOP);
+
+		std::vector<std::optional<double>> result;
+		result.reserve(targets.size());
+		for (const transportcatalogue::Stop* target : targets) {
+			const uint32_t stop = target->id;
+			result.push_back(buffers.IsReached(stop) ? std::optional<double>(buffers.labels[stop]) : std::nullopt);
+		}
+		return result;
+	}
+
+	std::vector<std::pair<const transportcatalogue::Stop*, double>> RaptorRouter::BuildTimesWithin(const transportcatalogue::Stop* from, double max_time) const {
+		QueryBuffers& buffers = GetQueryBuffers();
+		Search(buffers, from->id, NO_STOP, max_time);
+
+		std::vector<std::pair<const transportcatalogue::Stop*, double>> result;
+		for (uint32_t stop = 0; stop < stops_.size(); stop++) {
+			if (buffers.IsReached(stop)) {
+				result.emplace_back(stops_[stop], buffers.labels[stop]);
+			}
+		}
+		return result;
+	}
+
+	size_t RaptorRouter::Search(QueryBuffers& buffers, uint32_t source, uint32_t target, double max_time) const {
+		buffers.Prepare(stops_.size(), patterns_.size());
+		buffers.stamps[source] = buffers.current_stamp;
+		buffers.labels[source] = 0.;
+		if (source != target) {
+			buffers.marked_stops.push_back(source);
+		}
+
+		// Every round scans the patterns through the stops improved in the previous one, starting from the
+		// first improved stop of the pattern. A label of the target bounds all candidates, and the target
+		// itself is never marked, since no route leaving it again can be shorter.
+		size_t improved_labels = 0;
+		while (!buffers.marked_stops.empty()) {
+			for (uint32_t stop : buffers.marked_stops) {
+				buffers.is_marked[stop] = false;
+				for (size_t entry = stop_pattern_offsets_[stop]; entry < stop_pattern_offsets_[stop + 1]; entry++) {
+					const StopPattern& stop_pattern = stop_patterns_[entry];
+					uint32_t& first_position = buffers.first_positions[stop_pattern.pattern];
+					if (first_position == NO_POSITION) {
+						buffers.queued_patterns.push_back(stop_pattern.pattern);
+					}
+					first_position = std::min(first_position, stop_pattern.position);
+				}
+			}
+			buffers.marked_stops.clear();
+
+			for (uint32_t pattern_id : buffers.queued_patterns) {
+				const Pattern& pattern = patterns_[pattern_id];
+				uint32_t position = buffers.first_positions[pattern_id];
+				buffers.first_positions[pattern_id] = NO_POSITION;
+
+				bool boarded = false;
+				uint32_t board_position = 0;
+				double board_cost = 0.;
+				double ride_time = 0.;
+				for (; position < pattern.stops.size(); position++) {
+					const uint32_t stop = pattern.stops[position];
+					if (boarded) {
+						ride_time += pattern.segment_times[position - 1];
+						const double candidate = board_cost + ride_time;
+						if ((!buffers.IsReached(stop) || candidate < buffers.labels[stop]) && candidate <= max_time
+							&& (target == NO_STOP || !buffers.IsReached(target) || candidate < buffers.labels[target])) {
+							buffers.stamps[stop] = buffers.current_stamp;
+							buffers.labels[stop] = candidate;
+							buffers.parents[stop] = { pattern_id, board_position, position, ride_time };
+							improved_labels++;
+							if (stop != target && !buffers.is_marked[stop]) {
+								buffers.is_marked[stop] = true;
+								buffers.marked_stops.push_back(stop);
+							}
+						}
+					}
+					if (buffers.IsReached(stop) && (!boarded || buffers.labels[stop] + wait_time_ < board_cost + ride_time)) {
+						boarded = true;
+						board_position = position;
+						board_cost = buffers.labels[stop] + wait_time_;
+						ride_time = 0.;
+					}
+				}
+			}
+			buffers.queued_patterns.clear();
+		}
+		return improved_labels;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,112 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "search_buffers.h"
+#include "transport_catalogue.h"
+
+namespace transport_router {
+
+	// Round-based search over bus routes (RAPTOR). Instead of one graph edge for every pair of stops of a
+	// bus, every direction of a bus is kept as a pattern of stops and scanned stop by stop, so memory is
+	// linear in the total length of the routes. Every boarding costs the wait time, and the ride time is
+	// summed from the boarding stop on, exactly as TransportRouter::CreateEdge does.
+	class RaptorRouter {
+	public:
+		using SegmentTime = std::function<double(const transportcatalogue::Stop*, const transportcatalogue::Stop*)>;
+
+		struct Leg {
+			const transportcatalogue::Stop* board_stop;
+			const transportcatalogue::Bus* bus;
+			unsigned int span_count;
+			double ride_time;
+		};
+
+		struct Journey {
+			double total_time;
+			std::vector<Leg> legs;
+		};
+
+		RaptorRouter(const transportcatalogue::TransportCatalogue& db, double wait_time, const SegmentTime& segment_time);
+
+		// stats->settled_vertices receives the number of stop labels the rounds improved: RAPTOR scans
+		// routes rather than settling vertices, and this is the count its work grows with.
+		std::optional<Journey> BuildRoute(const transportcatalogue::Stop* from, const transportcatalogue::Stop* to, graph::SearchStats* stats = nullptr) const;
+
+		// Total times from one stop to each of targets, found by a single search without a target bound.
+		std::vector<std::optional<double>> BuildTimes(const transportcatalogue::Stop* from, const std::vector<const transportcatalogue::Stop*>& targets) const;
+
+		// Every stop reachable from one stop within max_time, in no particular order.
+		std::vector<std::pair<const transportcatalogue::Stop*, double>> BuildTimesWithin(const transportcatalogue::Stop* from, double max_time) const;
+
+	private:
+		struct Pattern {
+			const transportcatalogue::Bus* bus;
+			std::vector<uint32_t> stops;
+			// segment_times[i] is the ride from stops[i] to stops[i + 1].
+			std::vector<double> segment_times;
+		};
+
+		struct StopPattern {
+			uint32_t pattern;
+			uint32_t position;
+		};
+
+		// How the best label of a stop was reached: by riding pattern from board_position to alight_position.
+		struct Parent {
+			uint32_t pattern;
+			uint32_t board_position;
+			uint32_t alight_position;
+			double ride_time;
+		};
+
+		struct QueryBuffers {
+			std::vector<double> labels;
+			std::vector<Parent> parents;
+			std::vector<uint32_t> stamps;
+			uint32_t current_stamp = 0;
+			std::vector<bool> is_marked;
+			std::vector<uint32_t> marked_stops;
+			std::vector<uint32_t> first_positions;
+			std::vector<uint32_t> queued_patterns;
+
+			void Prepare(size_t stop_count, size_t pattern_count);
+
+			bool IsReached(uint32_t stop) const {
+				return stamps[stop] == current_stamp;
+			}
+		};
+
+		static QueryBuffers& GetQueryBuffers() {
+			thread_local QueryBuffers buffers;
+			return buffers;
+		}
+
+		// Fills the labels of the current query in buffers and returns the number of label improvements.
+		// Candidates not better than the label of target are dropped; NO_STOP searches the whole network.
+		// Candidates above max_time are dropped as well.
+		size_t Search(QueryBuffers& buffers, uint32_t source, uint32_t target, double max_time = std::numeric_limits<double>::infinity()) const;
+
+		void AddPattern(const transportcatalogue::Bus& bus, std::vector<uint32_t>&& stops, const SegmentTime& segment_time);
+
+		static constexpr uint32_t NO_POSITION = UINT32_MAX;
+
+		static constexpr uint32_t NO_STOP = UINT32_MAX;
+
+		double wait_time_;
+
+		// Indexed by Stop::id.
+		std::vector<const transportcatalogue::Stop*> stops_;
+
+		std::vector<Pattern> patterns_;
+
+		// Patterns through every stop: stop_patterns_[stop_pattern_offsets_[s] .. stop_pattern_offsets_[s + 1]).
+		std::vector<size_t> stop_pattern_offsets_;
+
+		std::vector<StopPattern> stop_patterns_;
+	};
+}
\ No newline at end of file
@@ -65,8 +65,16 @@ svg::Document RequestHandler::RenderMap() const {
 	return result;
 }
 
-std::optional<transport_router::RouteInfo> RequestHandler::GetRouteStat(const std::string& from, const std::string& to) const {
-	return router_->GetRouteInfo(from, to);
+std::shared_ptr<const transport_router::RouteInfo> RequestHandler::GetRouteStat(const std::string& from, const std::string& to, graph::SearchStats* stats) const {
+	return router_->GetRouteInfo(from, to, stats);
+}
+
+transport_router::RouteTimeMatrix RequestHandler::GetRouteMatrixStat(const std::vector<std::string_view>& from, const std::vector<std::string_view>& to) const {
+	return router_->GetRouteMatrix(from, to);
+}
+
+std::vector<std::pair<std::string_view, double>> RequestHandler::GetIsochroneStat(std::string_view stop, double max_time) const {
+	return router_->GetIsochrone(stop, max_time);
 }
 
 BusInfo RequestHandler::GetBusStat(std::string_view bus_name) const {
@@ -25,7 +25,11 @@ public:
     // Ýòîò ìåòîä áóäåò íóæåí â ñëåäóþùåé ÷àñòè èòîãîâîãî ïðîåêòà
     svg::Document RenderMap() const;
 
-    std::optional<transport_router::RouteInfo> GetRouteStat(const std::string& from, const std::string& to) const;
+    std::shared_ptr<const transport_router::RouteInfo> GetRouteStat(const std::string& from, const std::string& to, graph::SearchStats* stats = nullptr) const;
+
+    transport_router::RouteTimeMatrix GetRouteMatrixStat(const std::vector<std::string_view>& from, const std::vector<std::string_view>& to) const;
+
+    std::vector<std::pair<std::string_view, double>> GetIsochroneStat(std::string_view stop, double max_time) const;
 
 private:
     const TransportCatalogue& db_;
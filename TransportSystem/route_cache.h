@@ -0,0 +1,87 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <limits>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace transport_router {
+
+	struct CacheStats {
+		size_t hits = 0;
+		size_t misses = 0;
+		size_t evictions = 0;
+	};
+
+	// Bounded least-recently-used cache safe to share between threads. Keys are spread over shards with
+	// a mutex each, so concurrent queries for different keys rarely wait for one another. Values are
+	// computed outside of the lock; if two threads miss the same key at once, both compute it. The shard is
+	// picked by the high half of the hash, so the hasher has to mix the key into all of its bits.
+	template <typename Key, typename Value, typename Hasher = std::hash<Key>>
+	class ShardedLruCache {
+	public:
+		explicit ShardedLruCache(size_t capacity) :
+			shards_(std::clamp<size_t>(capacity, 1, MAX_SHARD_COUNT)) {
+			// The first capacity % shard count shards hold one entry more, so the shards hold capacity in total.
+			for (size_t shard = 0; shard < shards_.size(); shard++) {
+				shards_[shard].capacity = capacity / shards_.size() + (shard < capacity % shards_.size() ? 1 : 0);
+			}
+		}
+
+		template <typename Factory>
+		Value GetOrCompute(const Key& key, const Factory& factory) {
+			Shard& shard = shards_[(hasher_(key) >> SHARD_HASH_SHIFT) % shards_.size()];
+			{
+				std::lock_guard<std::mutex> guard(shard.mutex);
+				auto it = shard.positions.find(key);
+				if (it != shard.positions.end()) {
+					shard.entries.splice(shard.entries.begin(), shard.entries, it->second);
+					hits_++;
+					return it->second->second;
+				}
+			}
+			misses_++;
+
+			Value value = factory();
+
+			std::lock_guard<std::mutex> guard(shard.mutex);
+			if (shard.positions.count(key) == 0) {
+				shard.entries.emplace_front(key, value);
+				shard.positions.emplace(key, shard.entries.begin());
+				if (shard.entries.size() > shard.capacity) {
+					shard.positions.erase(shard.entries.back().first);
+					shard.entries.pop_back();
+					evictions_++;
+				}
+			}
+			return value;
+		}
+
+		CacheStats GetStats() const {
+			return { hits_.load(), misses_.load(), evictions_.load() };
+		}
+
+	private:
+		struct Shard {
+			std::mutex mutex;
+			size_t capacity = 0;
+			// Most recently used entries first.
+			std::list<std::pair<Key, Value>> entries;
+			std::unordered_map<Key, typename std::list<std::pair<Key, Value>>::iterator, Hasher> positions;
+		};
+
+		static constexpr size_t MAX_SHARD_COUNT = 16;
+		static constexpr int SHARD_HASH_SHIFT = std::numeric_limits<size_t>::digits / 2;
+
+		std::vector<Shard> shards_;
+		Hasher hasher_;
+
+		std::atomic<size_t> hits_ = 0;
+		std::atomic<size_t> misses_ = 0;
+		std::atomic<size_t> evictions_ = 0;
+	};
+}
\ No newline at end of file
@@ -0,0 +1,91 @@
+#pragma once
+
+#include "graph.h"
+
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <vector>
+
+namespace graph {
+
+    // Vertex-to-vertex route table stored as two contiguous row-major arrays: route weights
+    // (NO_ROUTE when the target is unreachable) and the last edge of each route (NO_EDGE for empty routes).
+    template <typename Weight>
+    class RouteMatrix {
+    public:
+        static constexpr Weight NO_ROUTE = std::numeric_limits<Weight>::has_infinity
+            ? std::numeric_limits<Weight>::infinity()
+            : std::numeric_limits<Weight>::max();
+        static constexpr uint32_t NO_EDGE = std::numeric_limits<uint32_t>::max();
+
+        RouteMatrix() = default;
+
+        explicit RouteMatrix(size_t vertex_count)
+            : vertex_count_(vertex_count)
+            , weights_(vertex_count * vertex_count, NO_ROUTE)
+            , prev_edges_(vertex_count * vertex_count, NO_EDGE) {
+        }
+
+        RouteMatrix(size_t vertex_count, std::vector<Weight>&& weights, std::vector<uint32_t>&& prev_edges)
+            : vertex_count_(vertex_count)
+            , weights_(std::move(weights))
+            , prev_edges_(std::move(prev_edges)) {
+        }
+
+        size_t GetVertexCount() const {
+            return vertex_count_;
+        }
+
+        bool HasRoute(VertexId from, VertexId to) const {
+            return weights_[from * vertex_count_ + to] != NO_ROUTE;
+        }
+
+        Weight GetWeight(VertexId from, VertexId to) const {
+            return weights_[from * vertex_count_ + to];
+        }
+
+        std::optional<EdgeId> GetPrevEdge(VertexId from, VertexId to) const {
+            const uint32_t prev_edge = prev_edges_[from * vertex_count_ + to];
+            if (prev_edge == NO_EDGE) {
+                return std::nullopt;
+            }
+            return prev_edge;
+        }
+
+        void Set(VertexId from, VertexId to, Weight weight, uint32_t prev_edge) {
+            weights_[from * vertex_count_ + to] = weight;
+            prev_edges_[from * vertex_count_ + to] = prev_edge;
+        }
+
+        Weight* GetWeightsRow(VertexId from) {
+            return weights_.data() + from * vertex_count_;
+        }
+
+        const Weight* GetWeightsRow(VertexId from) const {
+            return weights_.data() + from * vertex_count_;
+        }
+
+        uint32_t* GetPrevEdgesRow(VertexId from) {
+            return prev_edges_.data() + from * vertex_count_;
+        }
+
+        const uint32_t* GetPrevEdgesRow(VertexId from) const {
+            return prev_edges_.data() + from * vertex_count_;
+        }
+
+        const std::vector<Weight>& GetWeights() const {
+            return weights_;
+        }
+
+        const std::vector<uint32_t>& GetPrevEdges() const {
+            return prev_edges_;
+        }
+
+    private:
+        size_t vertex_count_ = 0;
+        std::vector<Weight> weights_;
+        std::vector<uint32_t> prev_edges_;
+    };
+
+}  // namespace graph
@@ -1,13 +1,22 @@
 #pragma once
 
 #include "graph.h"
+#include "min_plus_kernel.h"
+#include "route_matrix.h"
+#include "search_buffers.h"
 
 #include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <cstdint>
+#include <functional>
 #include <iterator>
+#include <list>
+#include <memory>
+#include <mutex>
 #include <optional>
 #include <stdexcept>
+#include <thread>
 #include <unordered_map>
 #include <utility>
 #include <vector>
@@ -17,19 +26,23 @@ namespace graph {
     template <typename Weight>
     class Router {
     public:
-        struct RouteInternalData {
-            Weight weight;
-            std::optional<EdgeId> prev_edge;
-        };
-
-        using RoutesInternalData = std::vector<std::vector<std::optional<RouteInternalData>>>;
+        using RoutesInternalData = RouteMatrix<Weight>;
     private:
         using Graph = DirectedWeightedGraph<Weight>;
 
 
 
     public:
-        explicit Router(const Graph& graph);
+        // Rows are computed by a single-source search on first use instead of all at once in the constructor.
+        // With a non-zero memory_budget (in bytes) the least recently used rows are evicted to stay within it;
+        // at least one row is always kept.
+        struct LazyRows {
+            size_t memory_budget = 0;
+        };
+
+        explicit Router(const Graph& graph, size_t thread_count = 1);
+
+        Router(const Graph& graph, LazyRows lazy_rows);
 
         explicit Router(const Graph* graph, RoutesInternalData&& data);
 
@@ -38,70 +51,218 @@ namespace graph {
             std::vector<EdgeId> edges;
         };
 
+        // Weights of the routes from one vertex, NO_ROUTE where there is none. Keeps a lazily computed row
+        // alive even if it is evicted meanwhile.
+        class RouteWeights {
+        public:
+            Weight operator[](VertexId to) const {
+                return weights_[to];
+            }
+
+            bool HasRoute(VertexId to) const {
+                return weights_[to] != RoutesInternalData::NO_ROUTE;
+            }
+
+        private:
+            friend class Router;
+
+            RouteWeights(const Weight* weights, std::shared_ptr<const void> row)
+                : weights_(weights)
+                , row_(std::move(row)) {
+            }
+
+            const Weight* weights_;
+            std::shared_ptr<const void> row_;
+        };
+
+        // Empty in the lazy mode.
         const RoutesInternalData& GetRoutesInternalData() const {
             return routes_internal_data_;
         }
 
-        std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const;
+        bool IsLazy() const {
+            return is_lazy_;
+        }
+
+        RouteWeights GetRouteWeights(VertexId from) const;
+
+        // In the lazy mode stats->settled_vertices receives the vertices settled while computing the row of
+        // from, 0 if the row was already there; a full table never searches.
+        std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to, SearchStats* stats = nullptr) const;
+
+        // Brings the routes up to date after the weights of changed_edges were changed in the graph and
+        // returns the number of recomputed rows. A row is only affected if its shortest route tree holds one
+        // of the edges or if a route through one of them became shorter than the tree route to its end;
+        // these rows are recomputed by a single-source search, the others are kept. A recomputed row has the
+        // route times of a full rebuild up to rounding, since Dijkstra sums the weights in another order, but
+        // among routes of equal time it may keep another one than Floyd-Warshall picks. The lazy mode just
+        // drops its rows.
+        size_t RepairRoutes(const std::vector<EdgeId>& changed_edges, size_t thread_count = 1);
 
     private:
+        struct LazyRow {
+            std::vector<Weight> weights;
+            std::vector<uint32_t> prev_edges;
+        };
+
+        // Dijkstra over the whole graph; the row has the same layout as a row of routes_internal_data_.
+        std::shared_ptr<const LazyRow> ComputeLazyRow(VertexId from, SearchStats* stats = nullptr) const;
+
+        std::shared_ptr<const LazyRow> GetLazyRow(VertexId from, SearchStats* stats = nullptr) const;
 
         void InitializeRoutesInternalData(const Graph& graph) {
             const size_t vertex_count = graph.GetVertexCount();
             for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
-                routes_internal_data_[vertex][vertex] = RouteInternalData{ ZERO_WEIGHT, std::nullopt };
+                routes_internal_data_.Set(vertex, vertex, ZERO_WEIGHT, RoutesInternalData::NO_EDGE);
                 for (const EdgeId edge_id : graph.GetIncidentEdges(vertex)) {
                     const auto& edge = graph.GetEdge(edge_id);
                     if (edge.weight < ZERO_WEIGHT) {
                         throw std::domain_error("Edges' weights should be non-negative");
                     }
-                    auto& route_internal_data = routes_internal_data_[vertex][edge.to];
-                    if (!route_internal_data || route_internal_data->weight > edge.weight) {
-                        route_internal_data = RouteInternalData{ edge.weight, edge_id };
+                    if (!routes_internal_data_.HasRoute(vertex, edge.to) || routes_internal_data_.GetWeight(vertex, edge.to) > edge.weight) {
+                        routes_internal_data_.Set(vertex, edge.to, edge.weight, static_cast<uint32_t>(edge_id));
                     }
                 }
             }
         }
 
-        void RelaxRoute(VertexId vertex_from, VertexId vertex_to, const RouteInternalData& route_from,
-            const RouteInternalData& route_to) {
-            auto& route_relaxing = routes_internal_data_[vertex_from][vertex_to];
-            const Weight candidate_weight = route_from.weight + route_to.weight;
-            if (!route_relaxing || candidate_weight < route_relaxing->weight) {
-                route_relaxing = { candidate_weight,
-                                  route_to.prev_edge ? route_to.prev_edge : route_from.prev_edge };
-            }
+        // Blocked Floyd-Warshall: for every block K of intermediate vertices the pivot tile is relaxed
+        // first, then the tiles of the pivot row and column, then all remaining tiles in parallel.
+        // A tile reads D[i][k] and D[k][j] from snapshots taken exactly at step k, so every cell goes
+        // through the same sequence of relaxations as in the plain triple loop and the result is bit-identical.
+        void RelaxRoutesInternalDataThroughBlock(size_t vertex_count, VertexId block_begin, size_t thread_count) {
+            const size_t block_count = (vertex_count + BLOCK_SIZE - 1) / BLOCK_SIZE;
+            const size_t pivot_block = block_begin / BLOCK_SIZE;
+
+            RelaxTile(vertex_count, pivot_block, pivot_block, pivot_block);
+
+            ParallelFor(2 * block_count, thread_count, [&](size_t task) {
+                const size_t other_block = task / 2;
+                if (other_block == pivot_block) {
+                    return;
+                }
+                if (task % 2 == 0) {
+                    RelaxTile(vertex_count, pivot_block, other_block, pivot_block);
+                }
+                else {
+                    RelaxTile(vertex_count, other_block, pivot_block, pivot_block);
+                }
+                });
+
+            ParallelFor(block_count * block_count, thread_count, [&](size_t task) {
+                const size_t row_block = task / block_count;
+                const size_t column_block = task % block_count;
+                if (row_block != pivot_block && column_block != pivot_block) {
+                    RelaxTile(vertex_count, row_block, column_block, pivot_block);
+                }
+                });
         }
 
-        void RelaxRoutesInternalDataThroughVertex(size_t vertex_count, VertexId vertex_through) {
-            for (VertexId vertex_from = 0; vertex_from < vertex_count; ++vertex_from) {
-                if (const auto& route_from = routes_internal_data_[vertex_from][vertex_through]) {
-                    for (VertexId vertex_to = 0; vertex_to < vertex_count; ++vertex_to) {
-                        if (const auto& route_to = routes_internal_data_[vertex_through][vertex_to]) {
-                            RelaxRoute(vertex_from, vertex_to, *route_from, *route_to);
-                        }
+        void RelaxTile(size_t vertex_count, size_t row_block, size_t column_block, size_t pivot_block) {
+            const VertexId row_begin = row_block * BLOCK_SIZE;
+            const VertexId row_end = std::min(row_begin + BLOCK_SIZE, vertex_count);
+            const VertexId column_begin = column_block * BLOCK_SIZE;
+            const VertexId column_end = std::min(column_begin + BLOCK_SIZE, vertex_count);
+            const VertexId pivot_begin = pivot_block * BLOCK_SIZE;
+            const VertexId pivot_end = std::min(pivot_begin + BLOCK_SIZE, vertex_count);
+
+            for (VertexId vertex_through = pivot_begin; vertex_through < pivot_end; ++vertex_through) {
+                const size_t step = vertex_through - pivot_begin;
+                Weight* const pivot_row_weights = pivot_row_weights_.data() + step * vertex_count;
+                uint32_t* const pivot_row_prev_edges = pivot_row_prev_edges_.data() + step * vertex_count;
+                if (row_block == pivot_block) {
+                    std::copy(routes_internal_data_.GetWeightsRow(vertex_through) + column_begin,
+                        routes_internal_data_.GetWeightsRow(vertex_through) + column_end, pivot_row_weights + column_begin);
+                    std::copy(routes_internal_data_.GetPrevEdgesRow(vertex_through) + column_begin,
+                        routes_internal_data_.GetPrevEdgesRow(vertex_through) + column_end, pivot_row_prev_edges + column_begin);
+                }
+                if (column_block == pivot_block) {
+                    for (VertexId vertex_from = row_begin; vertex_from < row_end; ++vertex_from) {
+                        pivot_column_weights_[vertex_from * BLOCK_SIZE + step] = routes_internal_data_.GetWeight(vertex_from, vertex_through);
+                        pivot_column_prev_edges_[vertex_from * BLOCK_SIZE + step] = routes_internal_data_.GetPrevEdgesRow(vertex_from)[vertex_through];
                     }
                 }
+                for (VertexId vertex_from = row_begin; vertex_from < row_end; ++vertex_from) {
+                    const Weight weight_from = pivot_column_weights_[vertex_from * BLOCK_SIZE + step];
+                    if (weight_from == RoutesInternalData::NO_ROUTE) {
+                        continue;
+                    }
+                    const uint32_t prev_edge_from = pivot_column_prev_edges_[vertex_from * BLOCK_SIZE + step];
+                    RelaxRowMinPlus(weight_from, prev_edge_from, pivot_row_weights + column_begin, pivot_row_prev_edges + column_begin,
+                        routes_internal_data_.GetWeightsRow(vertex_from) + column_begin,
+                        routes_internal_data_.GetPrevEdgesRow(vertex_from) + column_begin, column_end - column_begin);
+                }
+            }
+        }
+
+        template <typename Task>
+        static void ParallelFor(size_t task_count, size_t thread_count, const Task& task) {
+            std::atomic<size_t> next_task = 0;
+            auto worker = [&]() {
+                for (size_t current = next_task++; current < task_count; current = next_task++) {
+                    task(current);
+                }
+            };
+            std::vector<std::thread> threads;
+            for (size_t i = 1; i < std::min(thread_count, task_count); ++i) {
+                threads.emplace_back(worker);
+            }
+            worker();
+            for (std::thread& thread : threads) {
+                thread.join();
             }
         }
 
+        static constexpr size_t BLOCK_SIZE = 64;
+
         static constexpr Weight ZERO_WEIGHT{};
     private:
         const Graph& graph_;
         RoutesInternalData routes_internal_data_;
+
+        bool is_lazy_ = false;
+        size_t max_lazy_rows_ = 0;
+        // Most recently used rows first; rows are computed outside of the lock.
+        mutable std::mutex lazy_rows_mutex_;
+        mutable std::list<std::pair<VertexId, std::shared_ptr<const LazyRow>>> lazy_rows_;
+        mutable std::unordered_map<VertexId, typename std::list<std::pair<VertexId, std::shared_ptr<const LazyRow>>>::iterator> lazy_row_positions_;
+
+        // Row k (pivot_row_*) and column k (pivot_column_*) of the current pivot block as they were at step k.
+        std::vector<Weight> pivot_row_weights_;
+        std::vector<uint32_t> pivot_row_prev_edges_;
+        std::vector<Weight> pivot_column_weights_;
+        std::vector<uint32_t> pivot_column_prev_edges_;
     };
 
     template <typename Weight>
-    Router<Weight>::Router(const Graph& graph)
+    Router<Weight>::Router(const Graph& graph, size_t thread_count)
         : graph_(graph)
-        , routes_internal_data_(graph.GetVertexCount(),
-            std::vector<std::optional<RouteInternalData>>(graph.GetVertexCount()))
+        , routes_internal_data_(graph.GetVertexCount())
     {
         InitializeRoutesInternalData(graph);
 
         const size_t vertex_count = graph.GetVertexCount();
-        for (VertexId vertex_through = 0; vertex_through < vertex_count; ++vertex_through) {
-            RelaxRoutesInternalDataThroughVertex(vertex_count, vertex_through);
+        pivot_row_weights_.resize(BLOCK_SIZE * vertex_count);
+        pivot_row_prev_edges_.resize(BLOCK_SIZE * vertex_count);
+        pivot_column_weights_.resize(vertex_count * BLOCK_SIZE);
+        pivot_column_prev_edges_.resize(vertex_count * BLOCK_SIZE);
+        for (VertexId block_begin = 0; block_begin < vertex_count; block_begin += BLOCK_SIZE) {
+            RelaxRoutesInternalDataThroughBlock(vertex_count, block_begin, std::max<size_t>(thread_count, 1));
+        }
+        pivot_row_weights_ = {};
+        pivot_row_prev_edges_ = {};
+        pivot_column_weights_ = {};
+        pivot_column_prev_edges_ = {};
+    }
+
+    template <typename Weight>
+    Router<Weight>::Router(const Graph& graph, LazyRows lazy_rows)
+        : graph_(graph)
+        , is_lazy_(true)
+    {
+        const size_t row_size = graph.GetVertexCount() * (sizeof(Weight) + sizeof(uint32_t));
+        if (lazy_rows.memory_budget != 0 && row_size != 0) {
+            max_lazy_rows_ = std::max<size_t>(lazy_rows.memory_budget / row_size, 1);
         }
     }
 
@@ -111,24 +272,146 @@ namespace graph {
         , routes_internal_data_(std::move(data)) {
     }
 
+    template <typename Weight>
+    std::shared_ptr<const typename Router<Weight>::LazyRow> Router<Weight>::ComputeLazyRow(VertexId from, SearchStats* stats) const {
+        const size_t vertex_count = graph_.GetVertexCount();
+        auto row = std::make_shared<LazyRow>();
+        row->weights.assign(vertex_count, RoutesInternalData::NO_ROUTE);
+        row->prev_edges.assign(vertex_count, RoutesInternalData::NO_EDGE);
+
+        using QueueItem = std::pair<Weight, VertexId>;
+        std::vector<QueueItem> heap;
+        row->weights[from] = ZERO_WEIGHT;
+        heap.push_back({ ZERO_WEIGHT, from });
+        while (!heap.empty()) {
+            std::pop_heap(heap.begin(), heap.end(), std::greater<QueueItem>{});
+            const auto [weight, vertex] = heap.back();
+            heap.pop_back();
+            if (row->weights[vertex] < weight) {
+                continue;
+            }
+            if (stats != nullptr) {
+                ++stats->settled_vertices;
+            }
+            for (const EdgeId edge_id : graph_.GetIncidentEdges(vertex)) {
+                const auto& edge = graph_.GetEdge(edge_id);
+                const Weight candidate_weight = weight + edge.weight;
+                if (row->weights[edge.to] == RoutesInternalData::NO_ROUTE || candidate_weight < row->weights[edge.to]) {
+                    row->weights[edge.to] = candidate_weight;
+                    row->prev_edges[edge.to] = static_cast<uint32_t>(edge_id);
+                    heap.push_back({ candidate_weight, edge.to });
+                    std::push_heap(heap.begin(), heap.end(), std::greater<QueueItem>{});
+                }
+            }
+        }
+        return row;
+    }
+
+    template <typename Weight>
+    std::shared_ptr<const typename Router<Weight>::LazyRow> Router<Weight>::GetLazyRow(VertexId from, SearchStats* stats) const {
+        {
+            std::lock_guard<std::mutex> guard(lazy_rows_mutex_);
+            auto it = lazy_row_positions_.find(from);
+            if (it != lazy_row_positions_.end()) {
+                lazy_rows_.splice(lazy_rows_.begin(), lazy_rows_, it->second);
+                return it->second->second;
+            }
+        }
+
+        std::shared_ptr<const LazyRow> row = ComputeLazyRow(from, stats);
+
+        std::lock_guard<std::mutex> guard(lazy_rows_mutex_);
+        if (lazy_row_positions_.count(from) == 0) {
+            lazy_rows_.emplace_front(from, row);
+            lazy_row_positions_.emplace(from, lazy_rows_.begin());
+            if (max_lazy_rows_ != 0 && lazy_rows_.size() > max_lazy_rows_) {
+                lazy_row_positions_.erase(lazy_rows_.back().first);
+                lazy_rows_.pop_back();
+            }
+        }
+        return row;
+    }
+
+    template <typename Weight>
+    typename Router<Weight>::RouteWeights Router<Weight>::GetRouteWeights(VertexId from) const {
+        if (from >= graph_.GetVertexCount()) {
+            throw std::out_of_range("Vertex id is out of range");
+        }
+        if (!is_lazy_) {
+            return RouteWeights(routes_internal_data_.GetWeightsRow(from), nullptr);
+        }
+        std::shared_ptr<const LazyRow> row = GetLazyRow(from);
+        const Weight* weights = row->weights.data();
+        return RouteWeights(weights, std::move(row));
+    }
+
+    template <typename Weight>
+    size_t Router<Weight>::RepairRoutes(const std::vector<EdgeId>& changed_edges, size_t thread_count) {
+        if (is_lazy_) {
+            std::lock_guard<std::mutex> guard(lazy_rows_mutex_);
+            const size_t dropped_rows = lazy_rows_.size();
+            lazy_rows_.clear();
+            lazy_row_positions_.clear();
+            return dropped_rows;
+        }
+
+        const size_t vertex_count = routes_internal_data_.GetVertexCount();
+        std::vector<VertexId> affected_rows;
+        for (VertexId from = 0; from < vertex_count; ++from) {
+            const Weight* weights = routes_internal_data_.GetWeightsRow(from);
+            const uint32_t* prev_edges = routes_internal_data_.GetPrevEdgesRow(from);
+            const bool is_affected = std::any_of(changed_edges.begin(), changed_edges.end(), [&](EdgeId edge_id) {
+                const auto& edge = graph_.GetEdge(edge_id);
+                if (prev_edges[edge.to] == edge_id) {
+                    return true;
+                }
+                return weights[edge.from] != RoutesInternalData::NO_ROUTE
+                    && (weights[edge.to] == RoutesInternalData::NO_ROUTE || weights[edge.from] + edge.weight < weights[edge.to]);
+            });
+            if (is_affected) {
+                affected_rows.push_back(from);
+            }
+        }
+
+        ParallelFor(affected_rows.size(), std::max<size_t>(thread_count, 1), [&](size_t task) {
+            const VertexId from = affected_rows[task];
+            const std::shared_ptr<const LazyRow> row = ComputeLazyRow(from);
+            std::copy(row->weights.begin(), row->weights.end(), routes_internal_data_.GetWeightsRow(from));
+            std::copy(row->prev_edges.begin(), row->prev_edges.end(), routes_internal_data_.GetPrevEdgesRow(from));
+        });
+        return affected_rows.size();
+    }
+
     template <typename Weight>
     std::optional<typename Router<Weight>::RouteInfo> Router<Weight>::BuildRoute(VertexId from,
-        VertexId to) const {
-        const auto& route_internal_data = routes_internal_data_.at(from).at(to);
-        if (!route_internal_data) {
+        VertexId to, SearchStats* stats) const {
+        if (from >= graph_.GetVertexCount() || to >= graph_.GetVertexCount()) {
+            throw std::out_of_range("Vertex id is out of range");
+        }
+        std::shared_ptr<const LazyRow> lazy_row;
+        const Weight* weights = nullptr;
+        const uint32_t* prev_edges = nullptr;
+        if (is_lazy_) {
+            lazy_row = GetLazyRow(from, stats);
+            weights = lazy_row->weights.data();
+            prev_edges = lazy_row->prev_edges.data();
+        }
+        else {
+            weights = routes_internal_data_.GetWeightsRow(from);
+            prev_edges = routes_internal_data_.GetPrevEdgesRow(from);
+        }
+        if (weights[to] == RoutesInternalData::NO_ROUTE) {
             return std::nullopt;
         }
-        const Weight weight = route_internal_data->weight;
         std::vector<EdgeId> edges;
-        for (std::optional<EdgeId> edge_id = route_internal_data->prev_edge;
-            edge_id;
-            edge_id = routes_internal_data_[from][graph_.GetEdge(*edge_id).from]->prev_edge)
+        for (uint32_t edge_id = prev_edges[to]; edge_id != RoutesInternalData::NO_EDGE;
+            edge_id = prev_edges[graph_.GetEdge(edge_id).from])
         {
-            edges.push_back(*edge_id);
+            edges.push_back(edge_id);
         }
         std::reverse(edges.begin(), edges.end());
 
-        return RouteInfo{ weight, std::move(edges) };
+        return RouteInfo{ weights[to], std::move(edges) };
     }
 
 }  // namespace graph
\ No newline at end of file
@@ -0,0 +1,78 @@
+#pragma once
+
+#include "graph.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace graph {
+
+    struct SearchStats {
+        size_t settled_vertices = 0;
+    };
+
+    // Scratch memory of one single-source search, meant to be kept per thread and reused between queries.
+    // A vertex is reached in the current search only if its stamp equals current_stamp, so the buffers
+    // are never cleared between queries.
+    template <typename Weight>
+    struct SearchBuffers {
+        struct QueueItem {
+            Weight weight;
+            VertexId vertex;
+
+            bool operator>(const QueueItem& other) const {
+                return weight > other.weight;
+            }
+        };
+
+        std::vector<Weight> weights;
+        std::vector<EdgeId> prev_edges;
+        std::vector<uint32_t> stamps;
+        uint32_t current_stamp = 0;
+        std::vector<QueueItem> heap;
+
+        void Prepare(size_t vertex_count) {
+            if (stamps.size() < vertex_count) {
+                weights.resize(vertex_count);
+                prev_edges.resize(vertex_count);
+                stamps.resize(vertex_count, 0);
+            }
+            if (++current_stamp == 0) {
+                std::fill(stamps.begin(), stamps.end(), 0);
+                current_stamp = 1;
+            }
+            heap.clear();
+        }
+
+        bool IsReached(VertexId vertex) const {
+            return stamps[vertex] == current_stamp;
+        }
+
+        void Reach(VertexId vertex, Weight weight, EdgeId prev_edge) {
+            Reach(vertex, weight, prev_edge, weight);
+        }
+
+        // Goal-directed searches order the queue by a key other than the route weight itself.
+        void Reach(VertexId vertex, Weight weight, EdgeId prev_edge, Weight queue_key) {
+            stamps[vertex] = current_stamp;
+            weights[vertex] = weight;
+            prev_edges[vertex] = prev_edge;
+            heap.push_back({ queue_key, vertex });
+            std::push_heap(heap.begin(), heap.end(), std::greater<QueueItem>{});
+        }
+
+        const QueueItem& Top() const {
+            return heap.front();
+        }
+
+        QueueItem PopMin() {
+            std::pop_heap(heap.begin(), heap.end(), std::greater<QueueItem>{});
+            QueueItem result = heap.back();
+            heap.pop_back();
+            return result;
+        }
+    };
+
+}  // namespace graph
@@ -1,126 +1,174 @@
 #include "transport_catalogue.h"
 
+#include <atomic>
+#include <limits>
+
 namespace transportcatalogue {
 
 	void TransportCatalogue::AddBus(const std::string_view name, std::vector<std::string_view>&& stops, bool is_loop) {
+		bus_infos_.clear();
+		stop_bus_offsets_.clear();
+		stop_bus_ids_.clear();
 		std::string bus_name(name);
 		std::deque<Stop*> deq_stops;
-		Bus bus = { bus_name, {} , is_loop };
+		Bus bus = { bus_name, {} , is_loop, static_cast<uint32_t>(all_buses_.size()) };
 		all_buses_.push_back(bus);
 		buses_[all_buses_.back().name] = &all_buses_.back();
 
 		for (auto& stop : stops) {
-			if (stops_.count(stop) != 0) {
-				deq_stops.push_back(stops_.at(stop));
-			}
-			else {
+			if (stops_.count(stop) == 0) {
 				AddStop(stop, {});
-				deq_stops.push_back(stops_.at(stop));
-			}
-			if (std::find(buses_in_stop_[stops_.at(stop)->name].begin(), buses_in_stop_[stops_.at(stop)->name].end(), buses_.at(name)->name) == buses_in_stop_[stops_.at(stop)->name].end()) {
-				buses_in_stop_[stops_.at(stop)->name].push_back(buses_.at(name)->name);
 			}
+			deq_stops.push_back(stops_.at(stop));
 		}
 
-		buses_.at(name)->stops = deq_stops;
+		all_buses_.back().stops = deq_stops;
 	}
 
 	void TransportCatalogue::AddStop(const std::string_view name, const geo::Coordinates& location) {
+		bus_infos_.clear();
 		std::string stop_name(name);
-		Stop stop = { stop_name, location };
 		if (stops_.count(name) != 0) {
-			if (stops_.at(name)->coordinates.lat == 0. && stops_.at(name)->coordinates.lng == 0.) {
-				*stops_.at(name) = stop;
+			Stop& known_stop = *stops_.at(name);
+			if (known_stop.coordinates.lat == 0. && known_stop.coordinates.lng == 0.) {
+				known_stop = { stop_name, location, known_stop.id };
 			}
 		}
 		else {
-			all_stops_.push_back(stop);
+			all_stops_.push_back({ stop_name, location, static_cast<uint32_t>(all_stops_.size()) });
 			stops_[all_stops_.back().name] = &all_stops_.back();
+			stop_bus_offsets_.clear();
+			stop_bus_ids_.clear();
 		}
 	}
 
 	void TransportCatalogue::AddLenghtBetweenStops(const std::pair<std::string_view, std::string_view>& pair_stops, uint32_t lenght) {
-		Stop* p_stop_1 = stops_.at(pair_stops.first);
+		bus_infos_.clear();
+		const uint32_t first_stop_id = stops_.at(pair_stops.first)->id;
 		if (stops_.find(pair_stops.second) == stops_.end()) {
 			AddStop(pair_stops.second);
 		}
-		Stop* p_stop_2 = stops_.at(pair_stops.second);
-		length_between_stops_.insert({ { p_stop_1 , p_stop_2 }, lenght });
+		length_between_stops_.Insert(first_stop_id, stops_.at(pair_stops.second)->id, lenght);
+	}
+
+	void TransportCatalogue::SetLenghtBetweenStops(const std::pair<std::string_view, std::string_view>& pair_stops, uint32_t lenght) {
+		bus_infos_.clear();
+		length_between_stops_.Set(stops_.at(pair_stops.first)->id, stops_.at(pair_stops.second)->id, lenght);
 	}
 
 	[[nodiscard]] const BusInfo TransportCatalogue::GetInfoBus(std::string_view bus_name) const {
 		if (!BusAvailability(bus_name)) {
 			return { false, 0., 0, 0, 0 };
 		}
-		else {
-			int quantity_stop;
-			int unique_stops;
-
-			std::unordered_set<Stop*> stops;
+		const Bus& bus = *buses_.at(bus_name);
+		if (bus_infos_.size() == all_buses_.size()) {
+			return bus_infos_[bus.id];
+		}
+		return ComputeInfoBus(bus);
+	}
 
-			for (const auto& stop : buses_.at(bus_name)->stops) {
-				stops.insert(stop);
+	void TransportCatalogue::ComputeBusInfos(unsigned int thread_count) {
+		std::vector<BusInfo> bus_infos(all_buses_.size());
+		std::atomic<size_t> next_bus = 0;
+		auto worker = [&]() {
+			for (size_t bus = next_bus++; bus < bus_infos.size(); bus = next_bus++) {
+				bus_infos[bus] = ComputeInfoBus(all_buses_[bus]);
 			}
+		};
+		std::vector<std::thread> threads;
+		for (size_t i = 1; i < std::min<size_t>(thread_count, bus_infos.size()); ++i) {
+			threads.emplace_back(worker);
+		}
+		worker();
+		for (std::thread& thread : threads) {
+			thread.join();
+		}
+		bus_infos_ = std::move(bus_infos);
+	}
 
-			unique_stops = stops.size();
+	BusInfo TransportCatalogue::ComputeInfoBus(const Bus& bus) const {
+		std::vector<uint32_t> stop_ids;
+		stop_ids.reserve(bus.stops.size());
+		for (const Stop* stop : bus.stops) {
+			stop_ids.push_back(stop->id);
+		}
+		std::sort(stop_ids.begin(), stop_ids.end());
+		const int unique_stops = static_cast<int>(std::unique(stop_ids.begin(), stop_ids.end()) - stop_ids.begin());
 
-			if (buses_.at(bus_name)->is_loop_trip) {
-				quantity_stop = static_cast<int>(buses_.at(bus_name)->stops.size());
-			}
-			else {
-				quantity_stop = static_cast<int>(buses_.at(bus_name)->stops.size()) * 2 - 1;
-			}
+		int quantity_stop;
+		if (bus.is_loop_trip) {
+			quantity_stop = static_cast<int>(bus.stops.size());
+		}
+		else {
+			quantity_stop = static_cast<int>(bus.stops.size()) * 2 - 1;
+		}
 
-			double route_length = SummationLenght(*buses_.at(bus_name));
-			double curvature = static_cast<double>(route_length) / SummationLineLenght(*buses_.at(bus_name));
+		double route_length = SummationLenght(bus);
+		double curvature = static_cast<double>(route_length) / SummationLineLenght(bus);
 
-			return { true, curvature, route_length, quantity_stop, unique_stops };
-		}
+		return { true, curvature, route_length, quantity_stop, unique_stops };
 	}
 
 	[[nodiscard]] const StopInfo TransportCatalogue::GetInfoStop(std::string_view stop_name) const {
 		if (!StopAvailability(stop_name)) {
-			return { false, {} };
+			return { false, { stop_bus_ids_.end(), stop_bus_ids_.end() } };
 		}
-		else if (buses_in_stop_.count(stop_name) == 0) {
-			return { true, {} };
+		if (stop_bus_offsets_.size() != all_stops_.size() + 1) {
+			throw std::logic_error("Index of buses in stops is not built");
 		}
-		else {
-			StopInfo result = { true, buses_in_stop_.at(stop_name) };
-			std::sort(result.buses.begin(), result.buses.end());
-			return result;
+		const uint32_t stop_id = stops_.at(stop_name)->id;
+		return { true, { stop_bus_ids_.begin() + stop_bus_offsets_[stop_id], stop_bus_ids_.begin() + stop_bus_offsets_[stop_id + 1] } };
+	}
+
+	void TransportCatalogue::BuildStopBusIndex() {
+		std::vector<uint32_t> buses_by_name(all_buses_.size());
+		std::iota(buses_by_name.begin(), buses_by_name.end(), 0);
+		std::sort(buses_by_name.begin(), buses_by_name.end(), [this](uint32_t lhs, uint32_t rhs) {
+			return all_buses_[lhs].name < all_buses_[rhs].name;
+			});
+
+		// Both passes visit the buses in name order and count a bus once per stop, so the second one
+		// fills the list of every stop already sorted.
+		std::vector<uint32_t> last_bus(all_stops_.size(), std::numeric_limits<uint32_t>::max());
+		stop_bus_offsets_.assign(all_stops_.size() + 1, 0);
+		for (const uint32_t bus_id : buses_by_name) {
+			for (const Stop* stop : all_buses_[bus_id].stops) {
+				if (last_bus[stop->id] != bus_id) {
+					last_bus[stop->id] = bus_id;
+					++stop_bus_offsets_[stop->id + 1];
+				}
+			}
+		}
+		std::partial_sum(stop_bus_offsets_.begin(), stop_bus_offsets_.end(), stop_bus_offsets_.begin());
+
+		std::vector<uint32_t> positions(stop_bus_offsets_.begin(), std::prev(stop_bus_offsets_.end()));
+		std::fill(last_bus.begin(), last_bus.end(), std::numeric_limits<uint32_t>::max());
+		stop_bus_ids_.assign(stop_bus_offsets_.back(), 0);
+		for (const uint32_t bus_id : buses_by_name) {
+			for (const Stop* stop : all_buses_[bus_id].stops) {
+				if (last_bus[stop->id] != bus_id) {
+					last_bus[stop->id] = bus_id;
+					stop_bus_ids_[positions[stop->id]++] = bus_id;
+				}
+			}
 		}
 	}
 
 	double TransportCatalogue::SummationLenght(const Bus& bus) const {
 		if (bus.is_loop_trip) {
 			return std::transform_reduce(std::next(bus.stops.begin()), bus.stops.end(), bus.stops.begin(), 0, std::plus<>{}, [&](Stop* lhs, Stop* rhs) {
-				std::pair<Stop*, Stop*> pair_stops({ rhs , lhs });
-				if (length_between_stops_.count(pair_stops) != 0) {
-					return length_between_stops_.at(pair_stops);
-				}
-				return length_between_stops_.at({ lhs , rhs });
+				return GetLenghtBetweenStops(rhs->id, lhs->id);
 				}
 			);
 		}
 		else {
-			auto stops = bus.stops;
-			auto rstops = bus.stops;
-			rstops.pop_back();
-			std::reverse(rstops.begin(), rstops.end());
-			for (const auto& stop : rstops) {
-				stops.push_back(stop);
-			}
-			return std::transform_reduce(std::next(stops.begin()), stops.end(), stops.begin(), 0, std::plus<>{}, [&](Stop* lhs, Stop* rhs) {
-				std::pair<Stop*, Stop*> pair_stops({ rhs , lhs });
-				std::pair<Stop*, Stop*> revers_pair_stops({ lhs , rhs });
-				if (length_between_stops_.count(pair_stops) != 0) {
-					return length_between_stops_.at(pair_stops);
+			// There and back along the same stops, without building the whole sequence.
+			const int forward_lenght = std::transform_reduce(std::next(bus.stops.begin()), bus.stops.end(), bus.stops.begin(), 0, std::plus<>{}, [&](Stop* lhs, Stop* rhs) {
+				return GetLenghtBetweenStops(rhs->id, lhs->id);
 				}
-				else if (length_between_stops_.count(revers_pair_stops) != 0) {
-					return length_between_stops_.at(revers_pair_stops);
-				}
-				return length_between_stops_.at({ lhs , rhs });
+			);
+			return forward_lenght + std::transform_reduce(std::next(bus.stops.rbegin()), bus.stops.rend(), bus.stops.rbegin(), 0, std::plus<>{}, [&](Stop* lhs, Stop* rhs) {
+				return GetLenghtBetweenStops(rhs->id, lhs->id);
 				}
 			);
 		}
@@ -153,21 +201,21 @@ namespace transportcatalogue {
 		return result;
 	}
 
-	transport_catalogue_serialize::Bus TransportCatalogue::SaveBusToProto(const std::map<std::string_view, size_t>& stops, const Bus& bus) const {
+	transport_catalogue_serialize::Bus TransportCatalogue::SaveBusToProto(const Bus& bus) const {
 		transport_catalogue_serialize::Bus result;
 		result.set_is_loop(bus.is_loop_trip);
 		result.set_name(bus.name);
 		for (const Stop* stop : bus.stops) {
-			result.add_stops(stops.at(stop->name));
+			result.add_stops(stop->id);
 		}
 
 		return result;
 	}
 
-	transport_catalogue_serialize::Distance TransportCatalogue::SaveLenghtToProto(const std::map<std::string_view, size_t>& stops, const std::pair<Stop*, Stop*>& pair_stops, uint32_t lenght) const {
+	transport_catalogue_serialize::Distance TransportCatalogue::SaveLenghtToProto(uint32_t from_id, uint32_t to_id, uint32_t lenght) const {
 		transport_catalogue_serialize::Distance result;
-		result.set_from(stops.at(pair_stops.first->name));
-		result.set_to(stops.at(pair_stops.second->name));
+		result.set_from(from_id);
+		result.set_to(to_id);
 		result.set_lenght(lenght);
 
 		return result;
@@ -175,17 +223,24 @@ namespace transportcatalogue {
 
 	transport_catalogue_serialize::TransportCatalogue TransportCatalogue::SaveToProto() const {
 		transport_catalogue_serialize::TransportCatalogue result;
-		std::map<std::string_view, size_t> proto_stops;
 		for (const Stop& stop : all_stops_) {
-			proto_stops[stop.name] = result.stops_size();
 			*result.add_stops() = SaveStopToProto(stop);
 		}
 		for (const Bus& bus : all_buses_) {
-			*result.add_buses() = SaveBusToProto(proto_stops, bus);
+			*result.add_buses() = SaveBusToProto(bus);
 		}
-		for (const auto& [pair_stops, lenght] : length_between_stops_) {
-			*result.add_lenght_between_stops() = SaveLenghtToProto(proto_stops, pair_stops, lenght);
+		result.mutable_lenght_between_stops()->Reserve(static_cast<int>(length_between_stops_.GetSize()));
+		length_between_stops_.ForEach([this, &result](uint32_t from_id, uint32_t to_id, uint32_t lenght) {
+			*result.add_lenght_between_stops() = SaveLenghtToProto(from_id, to_id, lenght);
+			});
+		for (const BusInfo& bus_info : bus_infos_) {
+			result.add_bus_curvatures(bus_info.curvature);
+			result.add_bus_route_lengths(bus_info.route_length);
+			result.add_bus_stop_counts(bus_info.quantity_stop);
+			result.add_bus_unique_stop_counts(bus_info.unique_stops);
 		}
+		result.mutable_stop_bus_offsets()->Add(stop_bus_offsets_.begin(), stop_bus_offsets_.end());
+		result.mutable_stop_bus_ids()->Add(stop_bus_ids_.begin(), stop_bus_ids_.end());
 		return result;
 	}
 
@@ -207,6 +262,20 @@ namespace transportcatalogue {
 			uint32_t lenght = proto_dist.lenght();
 			result.AddLenghtBetweenStops(std::pair<std::string_view, std::string_view>{from, to}, lenght);
 		}
+		if (static_cast<size_t>(proto_catalogue.bus_curvatures_size()) == result.all_buses_.size()) {
+			result.bus_infos_.resize(result.all_buses_.size());
+			for (size_t bus = 0; bus < result.bus_infos_.size(); bus++) {
+				result.bus_infos_[bus] = { true, proto_catalogue.bus_curvatures(bus), proto_catalogue.bus_route_lengths(bus),
+					static_cast<int>(proto_catalogue.bus_stop_counts(bus)), static_cast<int>(proto_catalogue.bus_unique_stop_counts(bus)) };
+			}
+		}
+		if (static_cast<size_t>(proto_catalogue.stop_bus_offsets_size()) == result.all_stops_.size() + 1) {
+			result.stop_bus_offsets_.assign(proto_catalogue.stop_bus_offsets().begin(), proto_catalogue.stop_bus_offsets().end());
+			result.stop_bus_ids_.assign(proto_catalogue.stop_bus_ids().begin(), proto_catalogue.stop_bus_ids().end());
+		}
+		else {
+			result.BuildStopBusIndex();
+		}
 		return result;
 	}
 }
\ No newline at end of file
@@ -8,23 +8,30 @@
 #include <algorithm>
 #include <numeric>
 #include <functional>
-#include <unordered_set>
+#include <optional>
+#include <thread>
 
 #include <transport_catalogue.pb.h>
 
+#include "distance_table.h"
 #include "domain.h"
 
 using namespace std::string_literals;
 
 namespace transportcatalogue {
 
+	class TransportCatalogue;
+
+	TransportCatalogue DeserializeTransportCatalogue(const transport_catalogue_serialize::TransportCatalogue& proto_catalogue);
+
 	class TransportCatalogue {
+		friend TransportCatalogue DeserializeTransportCatalogue(const transport_catalogue_serialize::TransportCatalogue& proto_catalogue);
 	public:
 
 		using BusPtr = Bus*;
 		using StopPtr = Stop*;
 
-		const std::unordered_map<std::string_view, Bus*> GetBuses() const {
+		const std::unordered_map<std::string_view, Bus*>& GetBuses() const {
 			return buses_;
 		}
 
@@ -44,6 +51,14 @@ namespace transportcatalogue {
 			return stops_.at(stop_bus);
 		}
 
+		const Bus& GetBus(uint32_t bus_id) const {
+			return all_buses_.at(bus_id);
+		}
+
+		const Stop& GetStop(uint32_t stop_id) const {
+			return all_stops_.at(stop_id);
+		}
+
 		bool StopAvailability(std::string_view stop) const {
 			return stops_.count(stop) != 0;
 		}
@@ -58,10 +73,21 @@ namespace transportcatalogue {
 
 		void AddLenghtBetweenStops(const std::pair<std::string_view, std::string_view>&, uint32_t lenght);
 
+		// Unlike AddLenghtBetweenStops overwrites a known length; both stops must already be in the catalogue.
+		void SetLenghtBetweenStops(const std::pair<std::string_view, std::string_view>&, uint32_t lenght);
+
 		[[nodiscard]] const BusInfo GetInfoBus(std::string_view bus_name) const;
 
+		// Computes the statistics of every bus, spread over thread_count threads, so that GetInfoBus only
+		// looks them up. Changing the catalogue afterwards drops them until the next call.
+		void ComputeBusInfos(unsigned int thread_count = std::thread::hardware_concurrency());
+
+		// Requires the index of BuildStopBusIndex, which adding buses or stops drops.
 		[[nodiscard]] const StopInfo GetInfoStop(std::string_view stop_name) const;
 
+		// Lists the buses through every stop sorted by name once, after all buses are added.
+		void BuildStopBusIndex();
+
 		Bus& FindBus(const std::string_view name) const {
 			return *buses_.at(name);
 		}
@@ -71,20 +97,19 @@ namespace transportcatalogue {
 		}
 
 		uint32_t GetLenghtBetweenStops(std::string_view first_stop, std::string_view second_stop) const {
-			std::pair<Stop*, Stop*> pair_stop = { stops_.at(first_stop), stops_.at(second_stop) };
-			auto it = length_between_stops_.find(pair_stop);
-			if (it == length_between_stops_.end()) {
-				it = length_between_stops_.find(std::pair{ pair_stop.second, pair_stop.first });
-				if (it == length_between_stops_.end()) {
-					if (first_stop == second_stop) {
-						return 0;
-					}
-					else {
-						throw std::logic_error("Not found Lenght between this stops");
-					}
+			return GetLenghtBetweenStops(stops_.at(first_stop)->id, stops_.at(second_stop)->id);
+		}
+
+		// Falls back to the length in the opposite direction when only that one is known.
+		uint32_t GetLenghtBetweenStops(uint32_t first_stop_id, uint32_t second_stop_id) const {
+			const std::optional<uint32_t> lenght = length_between_stops_.Find(first_stop_id, second_stop_id);
+			if (!lenght) {
+				if (first_stop_id == second_stop_id) {
+					return 0;
 				}
+				throw std::logic_error("Not found Lenght between this stops");
 			}
-			return it->second;
+			return *lenght;
 		}
 
 		transport_catalogue_serialize::TransportCatalogue SaveToProto() const;
@@ -93,18 +118,11 @@ namespace transportcatalogue {
 
 		transport_catalogue_serialize::Stop SaveStopToProto(const Stop& stop) const;
 
-		transport_catalogue_serialize::Bus SaveBusToProto(const std::map<std::string_view, size_t>& stops, const Bus& bus) const;
+		transport_catalogue_serialize::Bus SaveBusToProto(const Bus& bus) const;
 
-		transport_catalogue_serialize::Distance SaveLenghtToProto(const std::map<std::string_view, size_t>& stops, const std::pair<Stop*, Stop*>& pair_stops, uint32_t lenght) const;
+		transport_catalogue_serialize::Distance SaveLenghtToProto(uint32_t from_id, uint32_t to_id, uint32_t lenght) const;
 
-		struct PairStopHasher {
-			size_t  operator()(const std::pair<Stop*, Stop*>& pair_stop) const {
-				size_t h_stop1 = ptr_hasher(pair_stop.first);
-				size_t h_stop2 = ptr_hasher(pair_stop.second);
-				return 47 * h_stop1 + h_stop2;
-			}
-			std::hash<const void*> ptr_hasher;
-		};
+		BusInfo ComputeInfoBus(const Bus& bus) const;
 
 		double SummationLineLenght(const Bus& bus) const;
 
@@ -114,13 +132,17 @@ namespace transportcatalogue {
 		std::unordered_map<std::string_view, Stop*> stops_;
 
 
-		std::unordered_map<std::string_view, std::deque<std::string_view>> buses_in_stop_;
+		// Ids of the buses through stop s, sorted by name, occupy [stop_bus_offsets_[s], stop_bus_offsets_[s + 1])
+		// of stop_bus_ids_; both are empty until BuildStopBusIndex.
+		std::vector<uint32_t> stop_bus_offsets_;
+		std::vector<uint32_t> stop_bus_ids_;
 
-		std::unordered_map<std::pair<Stop*, Stop*>, uint32_t, PairStopHasher> length_between_stops_;
+		StopDistanceTable length_between_stops_;
 
 		std::deque<Bus> all_buses_;
 		std::deque<Stop> all_stops_;
-	};
 
-	TransportCatalogue DeserializeTransportCatalogue(const transport_catalogue_serialize::TransportCatalogue& proto_catalogue);
+		// Indexed by bus id; empty until ComputeBusInfos.
+		std::vector<BusInfo> bus_infos_;
+	};
 }
\ No newline at end of file
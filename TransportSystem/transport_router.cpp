@@ -5,151 +5,717 @@ namespace transport_router {
 	TransportRouter::TransportRouter(RoutingSettings rs, const transportcatalogue::TransportCatalogue& db) :
 		settings_(rs),
 		db_(db) {
-		graph_of_stops = graph::DirectedWeightedGraph<double>(db.GetAllStops().size() * 2);
-		CreateGraph();
-		router_ptr_ = new graph::Router<double>(graph_of_stops);
+		if (settings_.algorithm_ != RoutingAlgorithm::RAPTOR) {
+			graph_of_stops = graph::DirectedWeightedGraph<double>(db.GetAllStops().size() * 2);
+			CreateGraph();
+		}
+		CreateRouter();
+		CreateRouteCache();
+		CreateStopComponents();
+	}
+
+	void TransportRouter::CreateStopComponents() {
+		std::vector<uint32_t> parents(db_.GetAllStops().size());
+		for (uint32_t stop = 0; stop < parents.size(); stop++) {
+			parents[stop] = stop;
+		}
+		auto find_root = [&parents](uint32_t stop) {
+			while (parents[stop] != stop) {
+				parents[stop] = parents[parents[stop]];
+				stop = parents[stop];
+			}
+			return stop;
+		};
+		for (const transportcatalogue::Bus& bus : db_.GetAllBuses()) {
+			for (auto it = bus.stops.begin(); it != bus.stops.end() && std::next(it) != bus.stops.end(); it++) {
+				const uint32_t first_root = find_root((*it)->id);
+				const uint32_t second_root = find_root((*std::next(it))->id);
+				parents[std::max(first_root, second_root)] = std::min(first_root, second_root);
+			}
+		}
+		stop_components_.resize(parents.size());
+		for (uint32_t stop = 0; stop < parents.size(); stop++) {
+			stop_components_[stop] = find_root(stop);
+		}
+	}
+
+	void TransportRouter::CreateRouteCache() {
+		if (settings_.route_cache_capacity_ != 0) {
+			route_cache_ptr_ = std::make_unique<RouteCache>(settings_.route_cache_capacity_);
+		}
 	}
 
 	void TransportRouter::CreateGraph() {
 		for (const transportcatalogue::Stop& stop : db_.GetAllStops()) {
 			CreateVertex(stop);
 		}
+		RideCandidates ride_candidates;
 		for (const transportcatalogue::Bus& bus : db_.GetAllBuses()) {
-			CreateEdge(bus);
+			CreateEdge(bus, ride_candidates);
 		}
+		for (const auto& [edge, trip] : ride_candidates.rides) {
+			graph_of_stops.AddEdge(edge);
+			info_about_edge.push_back(trip);
+		}
+		pruned_edges_count_ = ride_candidates.pruned_count;
+
+		const std::vector<graph::EdgeId> frozen_edge_ids = graph_of_stops.Freeze();
+		std::vector<RouteInfo::ComponentTrip> frozen_info_about_edge(info_about_edge.size());
+		for (graph::EdgeId id = 0; id < info_about_edge.size(); id++) {
+			frozen_info_about_edge[frozen_edge_ids[id]] = info_about_edge[id];
+		}
+		info_about_edge = std::move(frozen_info_about_edge);
+		CreateRideEdgeIndex();
 	}
 
-	void TransportRouter::CreateVertex(const transportcatalogue::Stop& stop) {
+	void TransportRouter::AddRideCandidate(RideCandidates& ride_candidates, const graph::Edge<double>& edge, const RouteInfo::ComponentTrip& trip) const {
+		const auto [it, inserted] = ride_candidates.positions.emplace(GetIdPairKey(edge.from, edge.to), ride_candidates.rides.size());
+		if (inserted) {
+			ride_candidates.rides.push_back({ edge, trip });
+			return;
+		}
+		ride_candidates.pruned_count++;
+		auto& ride = ride_candidates.rides[it->second];
+		if (edge.weight < ride.first.weight) {
+			ride = { edge, trip };
+		}
+	}
 
-		stop_vertexs_[stop.name].in = total_vertex++;
-		stop_vertexs_[stop.name].out = total_vertex++;
-		info_about_edge.emplace(graph_of_stops.AddEdge({ stop_vertexs_.at(stop.name).in,
-														 stop_vertexs_.at(stop.name).out,
-														 static_cast<double>(settings_.bus_wait_time_) }),
-			RouteInfo::ComponentTrip(stop.name, settings_.bus_wait_time_,
-				std::nullopt));
+	void TransportRouter::CreateVertexStops() {
+		vertex_stops_.assign(graph_of_stops.GetVertexCount(), 0);
+		for (const transportcatalogue::Stop& stop : db_.GetAllStops()) {
+			vertex_stops_[stop_vertexs_[stop.id].in] = stop.id;
+			vertex_stops_[stop_vertexs_[stop.id].out] = stop.id;
+		}
 	}
 
-	void TransportRouter::CreateEdge(const transportcatalogue::Bus& bus) {
+	void TransportRouter::CreateRideEdgeIndex() {
+		CreateVertexStops();
+		ride_edge_ids_.clear();
+		for (graph::EdgeId id = 0; id < graph_of_stops.GetEdgeCount(); id++) {
+			if (info_about_edge[id].span_count_.has_value()) {
+				const auto& edge = graph_of_stops.GetEdge(id);
+				ride_edge_ids_.emplace(GetIdPairKey(edge.from, edge.to), id);
+			}
+		}
+	}
+
+	void TransportRouter::CreateStopGraph() {
+		CreateVertexStops();
+
+		stop_graph_ = graph::DirectedWeightedGraph<double>(db_.GetAllStops().size());
+		stop_wait_edges_.assign(db_.GetAllStops().size(), 0);
+		stop_graph_ride_edges_.clear();
+		for (graph::EdgeId id = 0; id < graph_of_stops.GetEdgeCount(); id++) {
+			if (!info_about_edge[id].span_count_.has_value()) {
+				stop_wait_edges_[vertex_stops_[graph_of_stops.GetEdge(id).from]] = id;
+			}
+		}
+		for (graph::EdgeId id = 0; id < graph_of_stops.GetEdgeCount(); id++) {
+			if (info_about_edge[id].span_count_.has_value()) {
+				const auto& edge = graph_of_stops.GetEdge(id);
+				const size_t stop_from = vertex_stops_[edge.from];
+				stop_graph_.AddEdge({ stop_from, vertex_stops_[edge.to], graph_of_stops.GetEdge(stop_wait_edges_[stop_from]).weight + edge.weight });
+				stop_graph_ride_edges_.push_back(id);
+			}
+		}
+
+		const std::vector<graph::EdgeId> frozen_edge_ids = stop_graph_.Freeze();
+		std::vector<graph::EdgeId> frozen_ride_edges(stop_graph_ride_edges_.size());
+		for (graph::EdgeId id = 0; id < stop_graph_ride_edges_.size(); id++) {
+			frozen_ride_edges[frozen_edge_ids[id]] = stop_graph_ride_edges_[id];
+		}
+		stop_graph_ride_edges_ = std::move(frozen_ride_edges);
+		ride_stop_graph_edges_.assign(graph_of_stops.GetEdgeCount(), 0);
+		for (graph::EdgeId id = 0; id < stop_graph_ride_edges_.size(); id++) {
+			ride_stop_graph_edges_[stop_graph_ride_edges_[id]] = id;
+		}
+	}
+
+	void TransportRouter::CreateRouter() {
+		switch (settings_.algorithm_) {
+		case RoutingAlgorithm::DIJKSTRA:
+			dijkstra_router_ptr_ = std::make_unique<graph::DijkstraRouter<double>>(graph_of_stops);
+			break;
+		case RoutingAlgorithm::BIDIRECTIONAL_DIJKSTRA:
+			bidirectional_dijkstra_router_ptr_ = std::make_unique<graph::BidirectionalDijkstraRouter<double>>(graph_of_stops);
+			break;
+		case RoutingAlgorithm::A_STAR:
+			CreateVertexCoordinates();
+			a_star_router_ptr_ = std::make_unique<graph::AStarRouter<double>>(graph_of_stops);
+			break;
+		case RoutingAlgorithm::ALT:
+			landmarks_ptr_ = std::make_unique<graph::Landmarks<double>>(graph_of_stops, GetStopInVertices(), settings_.landmarks_count_);
+			a_star_router_ptr_ = std::make_unique<graph::AStarRouter<double>>(graph_of_stops);
+			break;
+		case RoutingAlgorithm::CONTRACTION_HIERARCHIES:
+			contraction_hierarchy_ptr_ = std::make_unique<graph::ContractionHierarchy<double>>(graph_of_stops);
+			break;
+		case RoutingAlgorithm::HUB_LABELS:
+			contraction_hierarchy_ptr_ = std::make_unique<graph::ContractionHierarchy<double>>(graph_of_stops);
+			hub_labels_ptr_ = std::make_unique<graph::HubLabels<double>>(*contraction_hierarchy_ptr_, GetStopInVertices());
+			break;
+		case RoutingAlgorithm::RAPTOR:
+			raptor_router_ptr_ = std::make_unique<RaptorRouter>(db_, settings_.bus_wait_time_,
+				[this](const transportcatalogue::Stop* from, const transportcatalogue::Stop* to) {
+					return CalculateTimeBetweenStations(from, to);
+				});
+			break;
+		default:
+			CreateStopGraph();
+			if (settings_.lazy_router_) {
+				router_ptr_ = std::make_unique<graph::Router<double>>(stop_graph_, graph::Router<double>::LazyRows{ settings_.router_memory_budget_ });
+			}
+			else {
+				router_ptr_ = std::make_unique<graph::Router<double>>(stop_graph_, settings_.threads_);
+			}
+		}
+		CreateSweepRouter();
+	}
+
+	void TransportRouter::CreateSweepRouter() {
+		if (dijkstra_router_ptr_ == nullptr && router_ptr_ == nullptr && raptor_router_ptr_ == nullptr) {
+			dijkstra_router_ptr_ = std::make_unique<graph::DijkstraRouter<double>>(graph_of_stops);
+		}
+	}
+
+	void TransportRouter::DeleteRouter() {
+		router_ptr_.reset();
+		dijkstra_router_ptr_.reset();
+		bidirectional_dijkstra_router_ptr_.reset();
+		hub_labels_ptr_.reset();
+		contraction_hierarchy_ptr_.reset();
+		a_star_router_ptr_.reset();
+		landmarks_ptr_.reset();
+		raptor_router_ptr_.reset();
+	}
+
+	size_t TransportRouter::UpdateRoadDistances(const std::vector<std::pair<std::string_view, std::string_view>>& changed_roads) {
+		route_cache_ptr_.reset();
+		CreateRouteCache();
+		if (settings_.algorithm_ == RoutingAlgorithm::RAPTOR) {
+			DeleteRouter();
+			CreateRouter();
+			return 0;
+		}
+		if (ride_edge_ids_.empty()) {
+			CreateRideEdgeIndex();
+		}
+
+		// A length falls back to the opposite direction, so a road changes the rides along it both ways.
+		std::unordered_set<uint64_t> changed_stop_pairs;
+		std::vector<uint32_t> affected_bus_ids;
+		for (const auto& [from, to] : changed_roads) {
+			const transportcatalogue::Stop* from_stop = db_.GetStop(from);
+			const transportcatalogue::Stop* to_stop = db_.GetStop(to);
+			changed_stop_pairs.insert(GetIdPairKey(from_stop->id, to_stop->id));
+			changed_stop_pairs.insert(GetIdPairKey(to_stop->id, from_stop->id));
+			for (const uint32_t bus_id : db_.GetInfoStop(from_stop->name).buses) {
+				affected_bus_ids.push_back(bus_id);
+			}
+		}
+		std::sort(affected_bus_ids.begin(), affected_bus_ids.end());
+		affected_bus_ids.erase(std::unique(affected_bus_ids.begin(), affected_bus_ids.end()), affected_bus_ids.end());
+		std::vector<bool> is_affected_bus(db_.GetAllBuses().size(), false);
+		RideCandidates affected_rides;
+		for (const uint32_t bus_id : affected_bus_ids) {
+			const transportcatalogue::Bus& bus = db_.GetBus(bus_id);
+			for (auto it = bus.stops.begin(); it != bus.stops.end() && std::next(it) != bus.stops.end(); it++) {
+				if (changed_stop_pairs.count(GetIdPairKey((*it)->id, (*std::next(it))->id)) != 0) {
+					is_affected_bus[bus_id] = true;
+					CreateEdge(bus, affected_rides);
+					break;
+				}
+			}
+		}
+
+		// Every edge keeps the cheapest ride of all buses, the earlier bus on a tie, as CreateGraph chose it. The
+		// times of the other buses did not change, so they only need to be recomputed for the pairs of stops
+		// whose ride was won by an affected bus that got slower.
+		auto is_cheaper = [this](const RouteInfo::ComponentTrip& trip, const RouteInfo::ComponentTrip& other) {
+			return trip.weight_ < other.weight_
+				|| (trip.weight_ == other.weight_ && db_.GetBus(trip.name_)->id < db_.GetBus(other.name_)->id);
+		};
+		std::vector<std::pair<graph::EdgeId, RouteInfo::ComponentTrip>> new_rides;
+		std::vector<std::pair<graph::EdgeId, RouteInfo::ComponentTrip>> slower_rides;
+		std::vector<bool> is_other_bus(db_.GetAllBuses().size(), false);
+		std::vector<uint32_t> other_bus_ids;
+		for (const auto& [edge, trip] : affected_rides.rides) {
+			const graph::EdgeId id = ride_edge_ids_.at(GetIdPairKey(edge.from, edge.to));
+			const RouteInfo::ComponentTrip& current_trip = info_about_edge[id];
+			if (!is_affected_bus[db_.GetBus(current_trip.name_)->id]) {
+				if (is_cheaper(trip, current_trip)) {
+					new_rides.emplace_back(id, trip);
+				}
+				continue;
+			}
+			if (trip.weight_ < current_trip.weight_ || (trip.weight_ == current_trip.weight_ && trip.name_ == current_trip.name_)) {
+				new_rides.emplace_back(id, trip);
+				continue;
+			}
+			slower_rides.emplace_back(id, trip);
+			const auto to_buses = db_.GetInfoStop(db_.GetStop(vertex_stops_[edge.to]).name).buses;
+			for (const uint32_t bus_id : db_.GetInfoStop(db_.GetStop(vertex_stops_[edge.from]).name).buses) {
+				if (!is_affected_bus[bus_id] && !is_other_bus[bus_id] && std::find(to_buses.begin(), to_buses.end(), bus_id) != to_buses.end()) {
+					is_other_bus[bus_id] = true;
+					other_bus_ids.push_back(bus_id);
+				}
+			}
+		}
+		std::sort(other_bus_ids.begin(), other_bus_ids.end());
+		RideCandidates other_rides;
+		for (const uint32_t bus_id : other_bus_ids) {
+			CreateEdge(db_.GetBus(bus_id), other_rides);
+		}
+		for (const auto& [id, trip] : slower_rides) {
+			const auto& edge = graph_of_stops.GetEdge(id);
+			const auto it = other_rides.positions.find(GetIdPairKey(edge.from, edge.to));
+			if (it != other_rides.positions.end() && is_cheaper(other_rides.rides[it->second].second, trip)) {
+				new_rides.emplace_back(id, other_rides.rides[it->second].second);
+			}
+			else {
+				new_rides.emplace_back(id, trip);
+			}
+		}
+
+		std::vector<graph::EdgeId> changed_edges;
+		for (const auto& [id, trip] : new_rides) {
+			info_about_edge[id] = trip;
+			if (graph_of_stops.GetEdge(id).weight != trip.weight_) {
+				graph_of_stops.SetEdgeWeight(id, trip.weight_);
+				changed_edges.push_back(id);
+			}
+		}
+
+		if (router_ptr_ != nullptr) {
+			std::vector<graph::EdgeId> changed_stop_graph_edges;
+			for (const graph::EdgeId id : changed_edges) {
+				const graph::EdgeId stop_graph_id = ride_stop_graph_edges_[id];
+				const size_t stop_from = vertex_stops_[graph_of_stops.GetEdge(id).from];
+				stop_graph_.SetEdgeWeight(stop_graph_id, graph_of_stops.GetEdge(stop_wait_edges_[stop_from]).weight + graph_of_stops.GetEdge(id).weight);
+				changed_stop_graph_edges.push_back(stop_graph_id);
+			}
+			router_ptr_->RepairRoutes(changed_stop_graph_edges, settings_.threads_);
+		}
+		else if (!changed_edges.empty()) {
+			DeleteRouter();
+			CreateRouter();
+		}
+		return changed_edges.size();
+	}
+
+	void TransportRouter::LoadRouter(const router_serialize::TransportRouter& proto_router) {
+		switch (settings_.algorithm_) {
+		case RoutingAlgorithm::DIJKSTRA:
+			dijkstra_router_ptr_ = std::make_unique<graph::DijkstraRouter<double>>(graph_of_stops);
+			break;
+		case RoutingAlgorithm::BIDIRECTIONAL_DIJKSTRA:
+			bidirectional_dijkstra_router_ptr_ = std::make_unique<graph::BidirectionalDijkstraRouter<double>>(graph_of_stops);
+			break;
+		case RoutingAlgorithm::A_STAR:
+			CreateVertexCoordinates();
+			a_star_router_ptr_ = std::make_unique<graph::AStarRouter<double>>(graph_of_stops);
+			break;
+		case RoutingAlgorithm::ALT: {
+			const router_serialize::Landmarks& proto_landmarks = proto_router.landmarks();
+			landmarks_ptr_ = std::make_unique<graph::Landmarks<double>>(graph_of_stops,
+				std::vector<graph::VertexId>(proto_landmarks.vertices().begin(), proto_landmarks.vertices().end()),
+				std::vector<double>(proto_landmarks.forward_weights().begin(), proto_landmarks.forward_weights().end()),
+				std::vector<double>(proto_landmarks.backward_weights().begin(), proto_landmarks.backward_weights().end()));
+			a_star_router_ptr_ = std::make_unique<graph::AStarRouter<double>>(graph_of_stops);
+			break;
+		}
+		case RoutingAlgorithm::CONTRACTION_HIERARCHIES:
+			LoadContractionHierarchy(proto_router.contraction_hierarchy());
+			break;
+		case RoutingAlgorithm::HUB_LABELS: {
+			LoadContractionHierarchy(proto_router.contraction_hierarchy());
+			auto load_labels = [](const router_serialize::Labels& proto_labels) {
+				return graph::HubLabels<double>::Labels{
+					{ proto_labels.offsets().begin(), proto_labels.offsets().end() },
+					{ proto_labels.hubs().begin(), proto_labels.hubs().end() },
+					{ proto_labels.weights().begin(), proto_labels.weights().end() },
+					{ proto_labels.parent_edges().begin(), proto_labels.parent_edges().end() } };
+			};
+			hub_labels_ptr_ = std::make_unique<graph::HubLabels<double>>(*contraction_hierarchy_ptr_,
+				load_labels(proto_router.hub_labels().forward()), load_labels(proto_router.hub_labels().backward()));
+			break;
+		}
+		case RoutingAlgorithm::RAPTOR:
+			raptor_router_ptr_ = std::make_unique<RaptorRouter>(db_, settings_.bus_wait_time_,
+				[this](const transportcatalogue::Stop* from, const transportcatalogue::Stop* to) {
+					return CalculateTimeBetweenStations(from, to);
+				});
+			break;
+		default:
+			CreateStopGraph();
+			if (settings_.lazy_router_) {
+				router_ptr_ = std::make_unique<graph::Router<double>>(stop_graph_, graph::Router<double>::LazyRows{ settings_.router_memory_budget_ });
+				break;
+			}
+			graph::Router<double>::RoutesInternalData routes_internal_data(proto_router.router().vertex_count(),
+				{ proto_router.router().weights().begin(), proto_router.router().weights().end() },
+				{ proto_router.router().prev_edges().begin(), proto_router.router().prev_edges().end() });
+			router_ptr_ = std::make_unique<graph::Router<double>>(&stop_graph_, std::move(routes_internal_data));
+		}
+		CreateSweepRouter();
+	}
+
+	void TransportRouter::LoadContractionHierarchy(const router_serialize::ContractionHierarchy& proto_hierarchy) {
+		std::vector<graph::ContractionHierarchy<double>::Shortcut> shortcuts(proto_hierarchy.shortcut_weights_size());
+		for (size_t i = 0; i < shortcuts.size(); i++) {
+			shortcuts[i].from = proto_hierarchy.shortcut_from(i);
+			shortcuts[i].to = proto_hierarchy.shortcut_to(i);
+			shortcuts[i].weight = proto_hierarchy.shortcut_weights(i);
+			shortcuts[i].first_edge = proto_hierarchy.shortcut_first_edges(i);
+			shortcuts[i].second_edge = proto_hierarchy.shortcut_second_edges(i);
+		}
+		contraction_hierarchy_ptr_ = std::make_unique<graph::ContractionHierarchy<double>>(graph_of_stops,
+			std::vector<uint32_t>(proto_hierarchy.ranks().begin(), proto_hierarchy.ranks().end()), std::move(shortcuts));
+	}
+
+	std::vector<graph::VertexId> TransportRouter::GetStopInVertices() const {
+		std::vector<graph::VertexId> result;
+		result.reserve(stop_vertexs_.size());
+		for (const VertexId& id : stop_vertexs_) {
+			result.push_back(id.in);
+		}
+		return result;
+	}
+
+	void TransportRouter::CreateVertexCoordinates() {
+		vertex_coordinates_.assign(graph_of_stops.GetVertexCount(), {});
+		for (const transportcatalogue::Stop& stop : db_.GetAllStops()) {
+			vertex_coordinates_[stop_vertexs_[stop.id].in] = stop.coordinates;
+			vertex_coordinates_[stop_vertexs_[stop.id].out] = stop.coordinates;
+		}
+
+		// Road distances are not guaranteed to exceed the great-circle ones, so instead of trusting
+		// bus_velocity_ the bound is taken from the fastest segment actually present in the network.
+		minutes_per_meter_ = 60.0 / (1000.0 * settings_.bus_velocity_);
+		auto account_segment = [this](const transportcatalogue::Stop* from, const transportcatalogue::Stop* to) {
+			const double distance = geo::ComputeDistance(from->coordinates, to->coordinates);
+			if (distance > 0.) {
+				minutes_per_meter_ = std::min(minutes_per_meter_, CalculateTimeBetweenStations(from, to) / distance);
+			}
+		};
+		for (const transportcatalogue::Bus& bus : db_.GetAllBuses()) {
+			for (auto it = bus.stops.begin(); it != bus.stops.end() && std::next(it) != bus.stops.end(); it++) {
+				account_segment(*it, *std::next(it));
+				if (!bus.is_loop_trip) {
+					account_segment(*std::next(it), *it);
+				}
+			}
+		}
+	}
+
+	double TransportRouter::EstimateTimeBetweenVertices(graph::VertexId from, graph::VertexId to) const {
+		const double distance = geo::ComputeDistance(vertex_coordinates_[from], vertex_coordinates_[to]);
+		return distance > 0. ? distance * minutes_per_meter_ : 0.;
+	}
+
+	void TransportRouter::CreateVertex(const transportcatalogue::Stop& stop) {
+		VertexId& stop_vertex = stop_vertexs_.emplace_back();
+		stop_vertex.in = total_vertex++;
+		stop_vertex.out = total_vertex++;
+		graph_of_stops.AddEdge({ stop_vertex.in, stop_vertex.out, static_cast<double>(settings_.bus_wait_time_) });
+		info_about_edge.push_back(RouteInfo::ComponentTrip(stop.name, settings_.bus_wait_time_, std::nullopt));
+	}
+
+	void TransportRouter::CreateEdge(const transportcatalogue::Bus& bus, RideCandidates& ride_candidates) const {
 		for (auto from_it = bus.stops.begin(); from_it != bus.stops.end(); from_it++) {
 			double time_to_road = 0;
 			int stops_count = 0;
-			graph::VertexId first_id = stop_vertexs_.at((*from_it)->name).out;
+			graph::VertexId first_id = stop_vertexs_[(*from_it)->id].out;
 			for (auto to_it = std::next(from_it); to_it != bus.stops.end(); to_it++) {
-				graph::VertexId second_id = stop_vertexs_.at((*to_it)->name).in;
+				graph::VertexId second_id = stop_vertexs_[(*to_it)->id].in;
 
-				time_to_road += CalculateTimeBetweenStations((*std::prev(to_it))->name, (*to_it)->name);
+				time_to_road += CalculateTimeBetweenStations(*std::prev(to_it), *to_it);
 				stops_count++;
 
 
-				info_about_edge.emplace(graph_of_stops.AddEdge({ first_id, second_id, time_to_road }), RouteInfo::ComponentTrip(bus.name, time_to_road, stops_count));
+				AddRideCandidate(ride_candidates, { first_id, second_id, time_to_road }, RouteInfo::ComponentTrip(bus.name, time_to_road, stops_count));
 			}
 		}
 		if (!bus.is_loop_trip) {
 			for (auto from_it = bus.stops.rbegin(); from_it != bus.stops.rend(); from_it++) {
 				double time_to_road = 0;
 				int stops_count = 0;
-				graph::VertexId first_id = stop_vertexs_.at((*from_it)->name).out;
+				graph::VertexId first_id = stop_vertexs_[(*from_it)->id].out;
 				for (auto to_it = std::next(from_it); to_it != bus.stops.rend(); to_it++) {
-					graph::VertexId second_id = stop_vertexs_.at((*to_it)->name).in;
+					graph::VertexId second_id = stop_vertexs_[(*to_it)->id].in;
 
-					time_to_road += CalculateTimeBetweenStations((*std::prev(to_it))->name, (*to_it)->name);
+					time_to_road += CalculateTimeBetweenStations(*std::prev(to_it), *to_it);
 					stops_count++;
 
 
-					info_about_edge.emplace(graph_of_stops.AddEdge({ first_id, second_id, time_to_road }), RouteInfo::ComponentTrip(bus.name, time_to_road, stops_count));
+					AddRideCandidate(ride_candidates, { first_id, second_id, time_to_road }, RouteInfo::ComponentTrip(bus.name, time_to_road, stops_count));
 				}
 			}
 		}
 	}
 
-	std::optional<RouteInfo> TransportRouter::GetRouteInfo(std::string_view from, std::string_view to) const {
-		if (stop_vertexs_.find(from) == stop_vertexs_.end()) {
+	std::shared_ptr<const RouteInfo> TransportRouter::GetRouteInfo(std::string_view from, std::string_view to, graph::SearchStats* stats) const {
+		if (!db_.StopAvailability(from)) {
 			throw std::logic_error("there is no starting stop"s);
 		}
+		const transportcatalogue::Stop* from_stop = db_.GetStop(from);
+		const transportcatalogue::Stop* to_stop = db_.GetStop(to);
+		if (stop_components_[from_stop->id] != stop_components_[to_stop->id]) {
+			return {};
+		}
+		if (stats != nullptr) {
+			stats->settled_vertices = 0;
+		}
+		if (route_cache_ptr_ == nullptr) {
+			return ComputeRouteInfo(from_stop, to_stop, stats);
+		}
+		const uint64_t stops = (static_cast<uint64_t>(from_stop->id) << 32) | to_stop->id;
+		return route_cache_ptr_->GetOrCompute(stops, [this, from_stop, to_stop, stats]() {
+			return ComputeRouteInfo(from_stop, to_stop, stats);
+			});
+	}
+
+	RouteTimeMatrix TransportRouter::GetRouteMatrix(const std::vector<std::string_view>& from, const std::vector<std::string_view>& to) const {
+		RouteTimeMatrix result;
+		result.reserve(from.size());
+		if (raptor_router_ptr_ != nullptr) {
+			std::vector<const transportcatalogue::Stop*> targets;
+			for (std::string_view stop : to) {
+				targets.push_back(db_.GetStop(stop));
+			}
+			for (std::string_view stop : from) {
+				result.push_back(raptor_router_ptr_->BuildTimes(db_.GetStop(stop), targets));
+			}
+			return result;
+		}
+
+		std::vector<graph::VertexId> targets;
+		for (std::string_view stop : to) {
+			targets.push_back(GetStopVertex(stop).in);
+		}
+		if (router_ptr_ != nullptr) {
+			for (std::string_view stop : from) {
+				const graph::Router<double>::RouteWeights weights = router_ptr_->GetRouteWeights(vertex_stops_[GetStopVertex(stop).in]);
+				std::vector<std::optional<double>>& row = result.emplace_back();
+				for (graph::VertexId target : targets) {
+					const size_t stop_to = vertex_stops_[target];
+					row.push_back(weights.HasRoute(stop_to) ? std::optional<double>(weights[stop_to]) : std::nullopt);
+				}
+			}
+			return result;
+		}
+
+		if (hub_labels_ptr_ != nullptr) {
+			for (std::string_view stop : from) {
+				const graph::VertexId source = GetStopVertex(stop).in;
+				std::vector<std::optional<double>>& row = result.emplace_back();
+				for (graph::VertexId target : targets) {
+					row.push_back(hub_labels_ptr_->GetWeight(source, target));
+				}
+			}
+			return result;
+		}
+
+		// The other graph modes only speed up point-to-point queries; a full sweep is plain Dijkstra.
+		for (std::string_view stop : from) {
+			result.push_back(dijkstra_router_ptr_->BuildWeights(GetStopVertex(stop).in, targets));
+		}
+		return result;
+	}
+
+	std::vector<std::pair<std::string_view, double>> TransportRouter::GetIsochrone(std::string_view stop, double max_time) const {
+		std::vector<std::pair<std::string_view, double>> result;
+		if (raptor_router_ptr_ != nullptr) {
+			for (const auto& [reached_stop, time] : raptor_router_ptr_->BuildTimesWithin(db_.GetStop(stop), max_time)) {
+				result.emplace_back(reached_stop->name, time);
+			}
+		}
+		else if (router_ptr_ != nullptr) {
+			const graph::Router<double>::RouteWeights weights = router_ptr_->GetRouteWeights(vertex_stops_[GetStopVertex(stop).in]);
+			for (const transportcatalogue::Stop& reached_stop : db_.GetAllStops()) {
+				if (weights.HasRoute(reached_stop.id) && weights[reached_stop.id] <= max_time) {
+					result.emplace_back(reached_stop.name, weights[reached_stop.id]);
+				}
+			}
+		}
+		else {
+			std::vector<std::string_view> in_vertex_stops(graph_of_stops.GetVertexCount());
+			for (const transportcatalogue::Stop& reached_stop : db_.GetAllStops()) {
+				in_vertex_stops[stop_vertexs_[reached_stop.id].in] = reached_stop.name;
+			}
+			for (const auto& [vertex, weight] : dijkstra_router_ptr_->BuildWeightsWithin(GetStopVertex(stop).in, max_time)) {
+				if (!in_vertex_stops[vertex].empty()) {
+					result.emplace_back(in_vertex_stops[vertex], weight);
+				}
+			}
+		}
+		std::sort(result.begin(), result.end(), [](const auto& lhs, const auto& rhs) {
+			return std::tie(lhs.second, lhs.first) < std::tie(rhs.second, rhs.first);
+			});
+		return result;
+	}
+
+	std::shared_ptr<const RouteInfo> TransportRouter::ComputeRouteInfo(const transportcatalogue::Stop* from, const transportcatalogue::Stop* to, graph::SearchStats* stats) const {
+		if (raptor_router_ptr_ != nullptr) {
+			return GetRaptorRouteInfo(from, to, stats);
+		}
 		RouteInfo result;
 
-		std::optional<graph::Router<double>::RouteInfo> route_info = router_ptr_->BuildRoute(stop_vertexs_.at(from).in, stop_vertexs_.at(to).in);
+		std::optional<graph::Router<double>::RouteInfo> route_info = BuildRoute(stop_vertexs_[from->id].in, stop_vertexs_[to->id].in, stats);
 
 		if (!route_info) {
 			return {};
 		}
 
 		for (graph::EdgeId id : route_info.value().edges) {
-			RouteInfo::ComponentTrip info = info_about_edge.at(id);
+			const RouteInfo::ComponentTrip& info = info_about_edge[id];
 			info.span_count_.has_value() ? result.AddRideItem(info.name_, info.span_count_.value(), info.weight_) : result.AddWaitItem(info.name_, info.weight_);
 			result.AdditionTotalTime(info.weight_);
 		}
 
-		return result;
+		return std::make_shared<const RouteInfo>(std::move(result));
 	}
 
-	double TransportRouter::CalculateTimeBetweenStations(std::string_view first_stop, std::string_view second_stop) const {
-		return db_.GetLenghtBetweenStops(first_stop, second_stop) / (1000.0 * settings_.bus_velocity_) * 60.0;
+	std::shared_ptr<const RouteInfo> TransportRouter::GetRaptorRouteInfo(const transportcatalogue::Stop* from, const transportcatalogue::Stop* to, graph::SearchStats* stats) const {
+		RouteInfo result;
+
+		std::optional<RaptorRouter::Journey> journey = raptor_router_ptr_->BuildRoute(from, to, stats);
+
+		if (!journey) {
+			return {};
+		}
+
+		for (const RaptorRouter::Leg& leg : journey->legs) {
+			result.AddWaitItem(leg.board_stop->name, settings_.bus_wait_time_);
+			result.AdditionTotalTime(settings_.bus_wait_time_);
+			result.AddRideItem(leg.bus->name, leg.span_count, leg.ride_time);
+			result.AdditionTotalTime(leg.ride_time);
+		}
+
+		return std::make_shared<const RouteInfo>(std::move(result));
+	}
+
+	std::optional<graph::Router<double>::RouteInfo> TransportRouter::BuildRoute(graph::VertexId from, graph::VertexId to, graph::SearchStats* stats) const {
+		switch (settings_.algorithm_) {
+		case RoutingAlgorithm::DIJKSTRA:
+			return dijkstra_router_ptr_->BuildRoute(from, to, stats);
+		case RoutingAlgorithm::BIDIRECTIONAL_DIJKSTRA:
+			return bidirectional_dijkstra_router_ptr_->BuildRoute(from, to, stats);
+		case RoutingAlgorithm::A_STAR:
+			return a_star_router_ptr_->BuildRoute(from, to, [this, to](graph::VertexId vertex) {
+				return EstimateTimeBetweenVertices(vertex, to);
+				}, stats);
+		case RoutingAlgorithm::ALT:
+			return a_star_router_ptr_->BuildRoute(from, to, [this, to](graph::VertexId vertex) {
+				return landmarks_ptr_->GetLowerBound(vertex, to);
+				}, stats);
+		case RoutingAlgorithm::CONTRACTION_HIERARCHIES:
+			return contraction_hierarchy_ptr_->BuildRoute(from, to);
+		case RoutingAlgorithm::HUB_LABELS:
+			return hub_labels_ptr_->BuildRoute(from, to);
+		default:
+			std::optional<graph::Router<double>::RouteInfo> stop_route = router_ptr_->BuildRoute(vertex_stops_.at(from), vertex_stops_.at(to), stats);
+			if (!stop_route) {
+				return std::nullopt;
+			}
+			graph::Router<double>::RouteInfo result{ stop_route->weight, {} };
+			for (graph::EdgeId id : stop_route->edges) {
+				result.edges.push_back(stop_wait_edges_[stop_graph_.GetEdge(id).from]);
+				result.edges.push_back(stop_graph_ride_edges_[id]);
+			}
+			return result;
+		}
+	}
+
+	double TransportRouter::CalculateTimeBetweenStations(const transportcatalogue::Stop* first_stop, const transportcatalogue::Stop* second_stop) const {
+		return db_.GetLenghtBetweenStops(first_stop->id, second_stop->id) / (1000.0 * settings_.bus_velocity_) * 60.0;
 	}
 
 	router_serialize::RoutingSettings TransportRouter::SaveRoutingSettingsToProto() const {
 		router_serialize::RoutingSettings proto_settings;
 		proto_settings.set_bus_wait_time_(settings_.bus_wait_time_);
 		proto_settings.set_bus_velocity_(settings_.bus_velocity_);
+		proto_settings.set_routing_algorithm_(static_cast<uint32_t>(settings_.algorithm_));
+		proto_settings.set_route_cache_capacity(settings_.route_cache_capacity_);
+		proto_settings.set_lazy_router(settings_.lazy_router_);
+		proto_settings.set_router_memory_budget(settings_.router_memory_budget_);
+		proto_settings.set_landmarks_count(settings_.landmarks_count_);
 		return proto_settings;
 	}
 
 	router_serialize::DirectedWeightedGraph TransportRouter::SaveGraphToProto() const {
 		router_serialize::DirectedWeightedGraph proto_graph_of_stops;
-		for (size_t i = 0; i < graph_of_stops.GetEdgeCount(); i++) {
-			router_serialize::Edge proto_edge;
-			const auto& edge = graph_of_stops.GetEdge(i);
-			proto_edge.set_from(edge.from);
-			proto_edge.set_to(edge.from);
-			proto_edge.set_weight(edge.weight);
-			*proto_graph_of_stops.add_edges_() = proto_edge;
-		}
-		for (const auto& incidence_lists : graph_of_stops.GetIncidenceLists()) {
-			router_serialize::IncidenceList proto_incidence_lists_;
-			for (const auto& EdgeId : incidence_lists) {
-				proto_incidence_lists_.add_edgeids(EdgeId);
-			}
-			*proto_graph_of_stops.add_incidence_lists_() = proto_incidence_lists_;
+		proto_graph_of_stops.mutable_offsets()->Add(graph_of_stops.GetOffsets().begin(), graph_of_stops.GetOffsets().end());
+		proto_graph_of_stops.mutable_targets()->Reserve(graph_of_stops.GetEdgeCount());
+		proto_graph_of_stops.mutable_weights()->Reserve(graph_of_stops.GetEdgeCount());
+		for (graph::EdgeId id = 0; id < graph_of_stops.GetEdgeCount(); id++) {
+			proto_graph_of_stops.add_targets(graph_of_stops.GetEdge(id).to);
+			proto_graph_of_stops.add_weights(graph_of_stops.GetEdge(id).weight);
 		}
 		return proto_graph_of_stops;
 	}
 
 	router_serialize::Router TransportRouter::SaveRouterToProto() const {
 		router_serialize::Router proto_router;
-		for (const auto& internal_list : router_ptr_->GetRoutesInternalData()) {
-			router_serialize::RoutesInternalData proto_internal_list;
-			for (const auto& data : internal_list) {
-				if (data.has_value()) {
-					router_serialize::RouteInternalData proto_data;
-					proto_data.set_weight(data.value().weight);
-					if (data.value().prev_edge.has_value()) {
-						proto_data.mutable_prev_edge()->set_data(data.value().prev_edge.value());
-					}
-					proto_data.set_is_initialisation(true);
-					*proto_internal_list.add_data() = proto_data;
-				}
-				else {
-					router_serialize::RouteInternalData proto_data;
-					proto_data.set_is_initialisation(false);
-					*proto_internal_list.add_data() = proto_data;
-				}
-			}
-			*proto_router.add_routes_internal_data_() = proto_internal_list;
+		if (router_ptr_ == nullptr || router_ptr_->IsLazy()) {
+			return proto_router;
 		}
+		const graph::Router<double>::RoutesInternalData& routes_internal_data = router_ptr_->GetRoutesInternalData();
+		proto_router.set_vertex_count(routes_internal_data.GetVertexCount());
+		proto_router.mutable_weights()->Add(routes_internal_data.GetWeights().begin(), routes_internal_data.GetWeights().end());
+		proto_router.mutable_prev_edges()->Add(routes_internal_data.GetPrevEdges().begin(), routes_internal_data.GetPrevEdges().end());
 		return proto_router;
 	}
 
-	router_serialize::TransportRouter TransportRouter::SaveToProto() const {
-		router_serialize::TransportRouter result;
-		std::map<std::string_view, uint32_t> name_stops;
+	router_serialize::ContractionHierarchy TransportRouter::SaveContractionHierarchyToProto() const {
+		router_serialize::ContractionHierarchy proto_hierarchy;
+		if (contraction_hierarchy_ptr_ == nullptr) {
+			return proto_hierarchy;
+		}
+		proto_hierarchy.mutable_ranks()->Add(contraction_hierarchy_ptr_->GetRanks().begin(), contraction_hierarchy_ptr_->GetRanks().end());
+		for (const auto& shortcut : contraction_hierarchy_ptr_->GetShortcuts()) {
+			proto_hierarchy.add_shortcut_from(shortcut.from);
+			proto_hierarchy.add_shortcut_to(shortcut.to);
+			proto_hierarchy.add_shortcut_weights(shortcut.weight);
+			proto_hierarchy.add_shortcut_first_edges(shortcut.first_edge);
+			proto_hierarchy.add_shortcut_second_edges(shortcut.second_edge);
+		}
+		return proto_hierarchy;
+	}
+
+	router_serialize::Landmarks TransportRouter::SaveLandmarksToProto() const {
+		router_serialize::Landmarks proto_landmarks;
+		if (landmarks_ptr_ == nullptr) {
+			return proto_landmarks;
+		}
+		proto_landmarks.mutable_vertices()->Add(landmarks_ptr_->GetLandmarks().begin(), landmarks_ptr_->GetLandmarks().end());
+		proto_landmarks.mutable_forward_weights()->Add(landmarks_ptr_->GetForwardWeights().begin(), landmarks_ptr_->GetForwardWeights().end());
+		proto_landmarks.mutable_backward_weights()->Add(landmarks_ptr_->GetBackwardWeights().begin(), landmarks_ptr_->GetBackwardWeights().end());
+		return proto_landmarks;
+	}
 
-		for (const auto& stop : this->db_.GetAllStops()) {
-			result.add_stops(stop.name);
-			name_stops[stop.name] = result.stops_size() - 1;
+	router_serialize::HubLabels TransportRouter::SaveHubLabelsToProto() const {
+		router_serialize::HubLabels proto_hub_labels;
+		if (hub_labels_ptr_ == nullptr) {
+			return proto_hub_labels;
 		}
+		auto save_labels = [](const graph::HubLabels<double>::Labels& labels, router_serialize::Labels& proto_labels) {
+			proto_labels.mutable_offsets()->Add(labels.offsets.begin(), labels.offsets.end());
+			proto_labels.mutable_hubs()->Add(labels.hubs.begin(), labels.hubs.end());
+			proto_labels.mutable_weights()->Add(labels.weights.begin(), labels.weights.end());
+			proto_labels.mutable_parent_edges()->Add(labels.parent_edges.begin(), labels.parent_edges.end());
+		};
+		save_labels(hub_labels_ptr_->GetForwardLabels(), *proto_hub_labels.mutable_forward());
+		save_labels(hub_labels_ptr_->GetBackwardLabels(), *proto_hub_labels.mutable_backward());
+		return proto_hub_labels;
+	}
+
+	router_serialize::TransportRouter TransportRouter::SaveToProto() const {
+		router_serialize::TransportRouter result;
 
 		result.set_total_vertex_(total_vertex);
+		result.set_pruned_edges_count(pruned_edges_count_);
 
 		*result.mutable_settings_() = SaveRoutingSettingsToProto();
 
@@ -157,21 +723,30 @@ namespace transport_router {
 
 		*result.mutable_router() = SaveRouterToProto();
 
-		for (const auto& [name, id] : stop_vertexs_) {
-			router_serialize::VertexId proto_id;
-			proto_id.set_in(id.in);
-			proto_id.set_out(id.out);
-			(*result.mutable_stop_vertexs_())[name_stops.at(name)] = proto_id;
+		*result.mutable_contraction_hierarchy() = SaveContractionHierarchyToProto();
+
+		*result.mutable_landmarks() = SaveLandmarksToProto();
+
+		*result.mutable_hub_labels() = SaveHubLabelsToProto();
+
+		result.mutable_stop_components()->Add(stop_components_.begin(), stop_components_.end());
+
+		for (const VertexId& id : stop_vertexs_) {
+			result.add_stop_in_vertices(id.in);
+			result.add_stop_out_vertices(id.out);
 		}
 
-		for (const auto& [id, component] : info_about_edge) {
-			router_serialize::ComponentTrip proto_component_trip;
-			proto_component_trip.set_name(std::string(component.name_));
-			proto_component_trip.set_weight_(component.weight_);
+		for (graph::EdgeId id = 0; id < info_about_edge.size(); id++) {
+			const RouteInfo::ComponentTrip& component = info_about_edge[id];
 			if (component.span_count_.has_value()) {
-				proto_component_trip.mutable_span_count_()->set_data(component.span_count_.value());
+				result.add_edge_names(db_.GetBus(component.name_)->id);
+				result.add_edge_span_counts(component.span_count_.value());
+			}
+			else {
+				result.add_edge_names(db_.GetStop(component.name_)->id);
+				result.add_edge_span_counts(0);
 			}
-			(*result.mutable_info_about_edge())[id] = proto_component_trip;
+			result.add_edge_weights(component.weight_);
 		}
 
 		return result;
@@ -179,74 +754,44 @@ namespace transport_router {
 
 	transport_router::TransportRouter* DeserializeTransportRouter(const router_serialize::TransportRouter& proto_router, const transportcatalogue::TransportCatalogue& db) {
 
-		graph::Router<double>::RoutesInternalData routes_internal_data;
-		std::vector<graph::Edge<double>> edges;
-		std::vector<std::vector<graph::EdgeId>> incidence_lists;
-		{
-			for (const auto& proto_edge : proto_router.graph_of_stops_().edges_()) {
-				graph::Edge<double> edge;
-				edge.from = proto_edge.from();
-				edge.to = proto_edge.to();
-				edge.weight = proto_edge.weight();
-				edges.push_back(std::move(edge));
-			}
-
-			for (const auto& proto_incidence_lists : proto_router.graph_of_stops_().incidence_lists_()) {
-				std::vector<graph::EdgeId> EdgeIds;
-				for (uint32_t id : proto_incidence_lists.edgeids()) {
-					EdgeIds.push_back(id);
-				}
-				incidence_lists.push_back(std::move(EdgeIds));
-			}
-			std::vector<std::optional<graph::Router<double>::RouteInternalData>> internal_list;
-			for (const auto& proto_internal_list : proto_router.router().routes_internal_data_()) {
-				for (const auto& proto_internal : proto_internal_list.data()) {
-
-					if (proto_internal.is_initialisation()) {
-						graph::Router<double>::RouteInternalData data;
-						data.weight = proto_internal.weight();
-						if (proto_internal.has_prev_edge()) {
-							data.prev_edge = proto_internal.prev_edge().data();
-						}
-						else {
-							data.prev_edge = std::nullopt;
-						}
-						internal_list.push_back(std::move(data));
-					}
-					else {
-						internal_list.push_back(std::nullopt);
-					}
-				}
-				routes_internal_data.push_back(std::move(internal_list));
+		const router_serialize::DirectedWeightedGraph& proto_graph = proto_router.graph_of_stops_();
+		std::vector<graph::EdgeId> offsets(proto_graph.offsets().begin(), proto_graph.offsets().end());
+		std::vector<graph::Edge<double>> edges(proto_graph.targets_size());
+		for (graph::VertexId vertex = 0; vertex + 1 < offsets.size(); vertex++) {
+			for (graph::EdgeId id = offsets[vertex]; id < offsets[vertex + 1]; id++) {
+				edges[id] = { vertex, proto_graph.targets(id), proto_graph.weights(id) };
 			}
 		}
-		graph::DirectedWeightedGraph<double> graph_of_stop(std::move(edges), std::move(incidence_lists));
-		transport_router::TransportRouter* result = new TransportRouter(db, std::move(graph_of_stop), std::move(routes_internal_data));
+		graph::DirectedWeightedGraph<double> graph_of_stop(std::move(offsets), std::move(edges));
+		RoutingSettings settings(proto_router.settings_().bus_wait_time_(), proto_router.settings_().bus_velocity_(),
+			static_cast<RoutingAlgorithm>(proto_router.settings_().routing_algorithm_()));
+		settings.route_cache_capacity_ = proto_router.settings_().route_cache_capacity();
+		settings.lazy_router_ = proto_router.settings_().lazy_router();
+		settings.router_memory_budget_ = proto_router.settings_().router_memory_budget();
+		settings.landmarks_count_ = proto_router.settings_().landmarks_count();
+		transport_router::TransportRouter* result = new TransportRouter(settings, db, std::move(graph_of_stop));
 
-		{
-			RoutingSettings settings(proto_router.settings_().bus_wait_time_(), proto_router.settings_().bus_velocity_());
-			result->settings_ = settings;
-		}
 		result->total_vertex = proto_router.total_vertex_();
+		result->pruned_edges_count_ = proto_router.pruned_edges_count();
 
-
-		for (const auto& [name, id] : proto_router.stop_vertexs_()) {
-
-			result->stop_vertexs_[db.GetStop(proto_router.stops()[name])->name].in = id.in();
-			result->stop_vertexs_[db.GetStop(proto_router.stops()[name])->name].out = id.out();
+		result->stop_vertexs_.resize(proto_router.stop_in_vertices_size());
+		for (size_t stop = 0; stop < result->stop_vertexs_.size(); stop++) {
+			result->stop_vertexs_[stop].in = proto_router.stop_in_vertices(stop);
+			result->stop_vertexs_[stop].out = proto_router.stop_out_vertices(stop);
 		}
-		for (const auto& [id, component] : proto_router.info_about_edge()) {
-
-			if (component.has_span_count_()) {
-
-				RouteInfo::ComponentTrip info(db.GetBus(component.name())->name, component.weight_(), component.span_count_().data());
-				result->info_about_edge[id] = info;
+		result->info_about_edge.resize(proto_router.edge_weights_size());
+		for (graph::EdgeId id = 0; id < result->info_about_edge.size(); id++) {
+			const uint32_t span_count = proto_router.edge_span_counts(id);
+			if (span_count != 0) {
+				result->info_about_edge[id] = RouteInfo::ComponentTrip(db.GetBus(proto_router.edge_names(id)).name, proto_router.edge_weights(id), span_count);
 			}
 			else {
-				RouteInfo::ComponentTrip info(db.GetStop(component.name())->name, component.weight_(), std::nullopt);
-				result->info_about_edge[id] = info;
+				result->info_about_edge[id] = RouteInfo::ComponentTrip(db.GetStop(proto_router.edge_names(id)).name, proto_router.edge_weights(id), std::nullopt);
 			}
 		}
+		result->stop_components_.assign(proto_router.stop_components().begin(), proto_router.stop_components().end());
+		result->LoadRouter(proto_router);
+		result->CreateRouteCache();
 		return result;
 	}
 }
\ No newline at end of file
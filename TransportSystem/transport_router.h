@@ -1,15 +1,29 @@
 #pragma once
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 #include <string_view>
 #include <exception>
 #include <optional>
 #include <variant>
+#include <thread>
+#include <tuple>
+#include <utility>
+#include <algorithm>
+#include <memory>
 
 #include <transport_router.pb.h>
 
 #include "graph.h"
 #include "router.h"
+#include "dijkstra_router.h"
+#include "bidirectional_dijkstra_router.h"
+#include "contraction_hierarchy.h"
+#include "hub_labels.h"
+#include "astar_router.h"
+#include "landmarks.h"
+#include "raptor_router.h"
+#include "route_cache.h"
 #include "transport_catalogue.h"
 
 using namespace std::string_literals;
@@ -54,7 +68,7 @@ namespace transport_router {
 			items_.push_back(ComponentTrip(stop_name, time_wait, std::nullopt));
 		}
 
-		double GetTotalTime() {
+		double GetTotalTime() const {
 			return total_time;
 		}
 
@@ -62,20 +76,42 @@ namespace transport_router {
 			total_time += time;
 		}
 
-		std::vector<ComponentTrip> GetItems() {
+		const std::vector<ComponentTrip>& GetItems() const {
 			return items_;
 		}
 	};
 
+	enum class RoutingAlgorithm {
+		ALL_PAIRS,
+		DIJKSTRA,
+		CONTRACTION_HIERARCHIES,
+		A_STAR,
+		RAPTOR,
+		BIDIRECTIONAL_DIJKSTRA,
+		ALT,
+		HUB_LABELS
+	};
+
 	struct RoutingSettings {
 
-		RoutingSettings(unsigned short int bus_wait_time, unsigned short int bus_velocity) :
+		RoutingSettings(unsigned short int bus_wait_time, unsigned short int bus_velocity, RoutingAlgorithm algorithm = RoutingAlgorithm::ALL_PAIRS) :
 			bus_wait_time_(bus_wait_time),
-			bus_velocity_(bus_velocity) {
+			bus_velocity_(bus_velocity),
+			algorithm_(algorithm) {
 		};
 
 		unsigned short int bus_wait_time_;
 		unsigned short int bus_velocity_;
+		RoutingAlgorithm algorithm_;
+		unsigned int threads_ = std::thread::hardware_concurrency();
+		// Number of answered Route requests kept for repeated queries; 0 disables the cache.
+		size_t route_cache_capacity_ = 0;
+		// all_pairs only: compute table rows on first use instead of at make_base, keeping at most
+		// router_memory_budget_ bytes of them (0 means no limit).
+		bool lazy_router_ = false;
+		size_t router_memory_budget_ = 0;
+		// alt only: number of landmark stops whose route times bound the A* search from below.
+		unsigned int landmarks_count_ = 8;
 	};
 
 	struct VertexId {
@@ -83,40 +119,133 @@ namespace transport_router {
 		graph::VertexId out;
 	};
 
+	// Total times of the shortest routes, one row per origin; empty where the destination is unreachable.
+	using RouteTimeMatrix = std::vector<std::vector<std::optional<double>>>;
+
 	class TransportRouter {
 		friend transport_router::TransportRouter* DeserializeTransportRouter(const router_serialize::TransportRouter& proto_router, const transportcatalogue::TransportCatalogue& db);
 	public:
-		TransportRouter(const transportcatalogue::TransportCatalogue& db, graph::DirectedWeightedGraph<double>&& graph_of_stop, graph::Router<double>::RoutesInternalData&& routes_internal_data)
-			: settings_(RoutingSettings{ 0, 0 })
+		TransportRouter(RoutingSettings rs, const transportcatalogue::TransportCatalogue& db, graph::DirectedWeightedGraph<double>&& graph_of_stop)
+			: settings_(rs)
 			, db_(db)
-			, graph_of_stops(std::move(graph_of_stop))
-			, router_ptr_(new graph::Router(&graph_of_stops, std::move(routes_internal_data))) {
-
+			, graph_of_stops(std::move(graph_of_stop)) {
 		}
 
 		TransportRouter(RoutingSettings rs, const transportcatalogue::TransportCatalogue& db);
 
-		~TransportRouter() {
-			delete router_ptr_;
-		}
+		// Empty when there is no route. The route is shared with the route cache rather than copied.
+		// stats->settled_vertices receives the number of vertices the search settled, 0 when the route came
+		// from a precomputed table or the route cache. In raptor mode it is the number of stop labels the
+		// rounds improved, which is what its work grows with.
+		std::shared_ptr<const RouteInfo> GetRouteInfo(std::string_view from, std::string_view to, graph::SearchStats* stats = nullptr) const;
+
+		// Answered with one search or one table row scan per origin rather than a query per pair of stops.
+		RouteTimeMatrix GetRouteMatrix(const std::vector<std::string_view>& from, const std::vector<std::string_view>& to) const;
 
-		std::optional<RouteInfo> GetRouteInfo(std::string_view from, std::string_view to) const;
+		// Stops reachable from stop within max_time with their total times, fastest first.
+		std::vector<std::pair<std::string_view, double>> GetIsochrone(std::string_view stop, double max_time) const;
+
+		// Re-reads the road distances of changed_roads after they were changed in the catalogue and updates the
+		// weights of the affected rides in place: the stops, bus routes and edge ids stay as they are. Only the
+		// buses driving along one of the roads in either direction are recomputed, together with the buses
+		// that may become the cheapest ride where one of them got slower. The all_pairs table is repaired row
+		// by row, so its route times match make_base with the new distances while equally fast routes may take
+		// other rides; the other modes rebuild their precomputed data. Returns the number of rides whose time changed.
+		size_t UpdateRoadDistances(const std::vector<std::pair<std::string_view, std::string_view>>& changed_roads);
 
 		router_serialize::TransportRouter SaveToProto() const;
+
+		// Zero counters when the cache is disabled.
+		CacheStats GetRouteCacheStats() const {
+			return route_cache_ptr_ != nullptr ? route_cache_ptr_->GetStats() : CacheStats{};
+		}
+
+		// Rides dropped while building the graph because a cheaper ride connects the same pair of stops.
+		size_t GetPrunedEdgeCount() const {
+			return pruned_edges_count_;
+		}
 	private:
+		// Cheapest ride found so far for every (out vertex, in vertex) pair, in order of first appearance.
+		// Only these rides become edges: a more expensive parallel edge can never be on a shortest route.
+		struct RideCandidates {
+			std::vector<std::pair<graph::Edge<double>, RouteInfo::ComponentTrip>> rides;
+			std::unordered_map<uint64_t, size_t> positions;
+			size_t pruned_count = 0;
+		};
+
+		// Fibonacci hashing of the ids of both stops packed into 64 bits: every bit of the key reaches the
+		// high bits of the product, which pick the cache shard.
+		struct StopPairHasher {
+			size_t operator()(uint64_t stops) const {
+				return static_cast<size_t>(stops * 0x9E3779B97F4A7C15ull);
+			}
+		};
+
+		using RouteCache = ShardedLruCache<uint64_t, std::shared_ptr<const RouteInfo>, StopPairHasher>;
+
 		router_serialize::RoutingSettings SaveRoutingSettingsToProto() const;
 
 		router_serialize::DirectedWeightedGraph SaveGraphToProto() const;
 
 		router_serialize::Router SaveRouterToProto() const;
 
+		router_serialize::ContractionHierarchy SaveContractionHierarchyToProto() const;
+
+		router_serialize::Landmarks SaveLandmarksToProto() const;
+
+		router_serialize::HubLabels SaveHubLabelsToProto() const;
+
 		void CreateGraph();
 
+		void CreateStopGraph();
+
+		void CreateVertexStops();
+
+		void CreateRideEdgeIndex();
+
+		void CreateRouter();
+
+		// The point-to-point modes answer RouteMatrix and Isochrone requests with a plain Dijkstra sweep.
+		void CreateSweepRouter();
+
+		void DeleteRouter();
+
+		void CreateRouteCache();
+
+		void CreateStopComponents();
+
+		const VertexId& GetStopVertex(std::string_view stop) const {
+			return stop_vertexs_[db_.GetStop(stop)->id];
+		}
+
+		void LoadRouter(const router_serialize::TransportRouter& proto_router);
+
+		void LoadContractionHierarchy(const router_serialize::ContractionHierarchy& proto_hierarchy);
+
+		// In vertices of all stops in stop id order: every route starts and ends at one of them.
+		std::vector<graph::VertexId> GetStopInVertices() const;
+
+		void CreateVertexCoordinates();
+
+		std::shared_ptr<const RouteInfo> ComputeRouteInfo(const transportcatalogue::Stop* from, const transportcatalogue::Stop* to, graph::SearchStats* stats) const;
+
+		std::shared_ptr<const RouteInfo> GetRaptorRouteInfo(const transportcatalogue::Stop* from, const transportcatalogue::Stop* to, graph::SearchStats* stats) const;
+
+		std::optional<graph::Router<double>::RouteInfo> BuildRoute(graph::VertexId from, graph::VertexId to, graph::SearchStats* stats) const;
+
+		double EstimateTimeBetweenVertices(graph::VertexId from, graph::VertexId to) const;
+
 		void CreateVertex(const transportcatalogue::Stop& stop);
 
-		void CreateEdge(const transportcatalogue::Bus& bus);
+		void CreateEdge(const transportcatalogue::Bus& bus, RideCandidates& ride_candidates) const;
 
-		double CalculateTimeBetweenStations(std::string_view first_stop, std::string_view second_stop) const;
+		void AddRideCandidate(RideCandidates& ride_candidates, const graph::Edge<double>& edge, const RouteInfo::ComponentTrip& trip) const;
+
+		static uint64_t GetIdPairKey(uint32_t first_id, uint32_t second_id) {
+			return (static_cast<uint64_t>(first_id) << 32) | static_cast<uint64_t>(second_id);
+		}
+
+		double CalculateTimeBetweenStations(const transportcatalogue::Stop* first_stop, const transportcatalogue::Stop* second_stop) const;
 
 		RoutingSettings settings_;
 
@@ -126,11 +255,63 @@ namespace transport_router {
 
 		graph::DirectedWeightedGraph<double> graph_of_stops = {};
 
-		graph::Router<double>* router_ptr_ = nullptr;
+		// One vertex per stop and one edge per ride edge of graph_of_stops, weighted together with the wait
+		// before boarding. The all-pairs table is built over this graph, since routes only go from stop to stop.
+		graph::DirectedWeightedGraph<double> stop_graph_ = {};
+
+		std::vector<size_t> vertex_stops_ = {};
+
+		std::vector<graph::EdgeId> stop_wait_edges_ = {};
+
+		std::vector<graph::EdgeId> stop_graph_ride_edges_ = {};
+
+		// The inverse of stop_graph_ride_edges_, indexed by edge id of graph_of_stops.
+		std::vector<graph::EdgeId> ride_stop_graph_edges_ = {};
+
+		// Ride edge of graph_of_stops for every (out vertex, in vertex) pair it connects. Built with the graph;
+		// a base read back from a file builds it on its first update, since stat requests never need it.
+		std::unordered_map<uint64_t, graph::EdgeId> ride_edge_ids_ = {};
+
+		std::unique_ptr<graph::Router<double>> router_ptr_;
+
+		// Also built in the other point-to-point modes, for the sweeps of RouteMatrix and Isochrone requests.
+		std::unique_ptr<graph::DijkstraRouter<double>> dijkstra_router_ptr_;
+
+		std::unique_ptr<graph::BidirectionalDijkstraRouter<double>> bidirectional_dijkstra_router_ptr_;
+
+		std::unique_ptr<graph::ContractionHierarchy<double>> contraction_hierarchy_ptr_;
+
+		// Built over contraction_hierarchy_ptr_ for the stop in vertices, which also unpacks its routes.
+		std::unique_ptr<graph::HubLabels<double>> hub_labels_ptr_;
+
+		std::unique_ptr<graph::AStarRouter<double>> a_star_router_ptr_;
+
+		// Route times to and from a few landmark stops, a lower bound for A* that, unlike the coordinates,
+		// accounts for waits and for the roads being longer than the great-circle distance.
+		std::unique_ptr<graph::Landmarks<double>> landmarks_ptr_;
+
+		// Works on the bus routes of the catalogue directly; graph_of_stops is left empty in this mode.
+		std::unique_ptr<RaptorRouter> raptor_router_ptr_;
+
+		std::unique_ptr<RouteCache> route_cache_ptr_;
+
+		// Weakly connected component of every stop, joined along bus routes. Stops of different components
+		// have no route between them in either direction, so such queries are answered without a search.
+		std::vector<uint32_t> stop_components_ = {};
+
+		// Stop coordinates of every vertex and the fewest minutes any bus needs per meter of great-circle
+		// distance, which together give A* a lower bound of the remaining route time.
+		std::vector<geo::Coordinates> vertex_coordinates_ = {};
+
+		double minutes_per_meter_ = 0.;
+
+		// Indexed by Stop::id, which the base preserves.
+		std::vector<VertexId> stop_vertexs_ = {};
 
-		std::unordered_map<std::string_view, VertexId> stop_vertexs_ = {};
+		// Indexed by edge id of graph_of_stops.
+		std::vector<RouteInfo::ComponentTrip> info_about_edge = {};
 
-		std::unordered_map<graph::EdgeId, RouteInfo::ComponentTrip> info_about_edge = {};
+		size_t pruned_edges_count_ = 0;
 	};
 
 	transport_router::TransportRouter* DeserializeTransportRouter(const router_serialize::TransportRouter& proto_router, const transportcatalogue::TransportCatalogue& db);